@@ -0,0 +1,45 @@
+#include <cstdio>
+#include <cstdlib>
+
+#include "utils/color.hpp"
+#include "utils/time.hpp"
+
+using namespace polybar;
+
+namespace chrono = std::chrono;
+
+/**
+ * Report the cost of decoding hex colors in every supported form
+ *
+ * Usage: bench.color [ROUNDS]
+ */
+int main(int argc, char** argv) {
+  const string colors[]{"#abc", "#8abc", "#a1b2c3", "#80a1b2c3", "#invalid"};
+  size_t rounds{argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 200000UL};
+
+  if (rounds == 0) {
+    fprintf(stderr, "Invalid round count: %s\n", argv[1]);
+    return EXIT_FAILURE;
+  }
+
+  uint32_t sum{0};
+
+  auto parse_us = time_util::measure<chrono::microseconds>([&] {
+    for (size_t i = 0; i < rounds; i++) {
+      for (auto&& color : colors) {
+        sum += color_util::parse(color);
+      }
+    }
+  });
+
+  // Keeps the loop from being optimized away
+  if (sum != static_cast<uint32_t>(rounds * (0xffaabbccULL + 0x88aabbcc + 0xffa1b2c3 + 0x80a1b2c3))) {
+    fprintf(stderr, "Unexpected checksum %08x\n", sum);
+    return EXIT_FAILURE;
+  }
+
+  printf("color: %zu parses\n", rounds * 5);
+  printf("  parse           %ld us\n", static_cast<long>(parse_us));
+
+  return EXIT_SUCCESS;
+}
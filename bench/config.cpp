@@ -0,0 +1,109 @@
+#include <unistd.h>
+#include <cstdio>
+#include <fstream>
+
+#include "components/config.hpp"
+#include "components/logger.hpp"
+#include "utils/time.hpp"
+#include "x11/connection.hpp"
+#include "x11/xresources.hpp"
+
+using namespace polybar;
+
+namespace chrono = std::chrono;
+
+/**
+ * Load a generated config where each module section inherits from a chain
+ * of base sections and report the cost of loading it and looking up its values
+ *
+ * Usage: bench.config [LINES]
+ */
+int main(int argc, char** argv) {
+  const logger& logger{logger::make(loglevel::ERROR)};
+
+  size_t target{argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 3000UL};
+
+  if (target == 0) {
+    logger.err("Invalid line count: %s", argv[1]);
+    return EXIT_FAILURE;
+  }
+
+  string contents{"[colors]\nbackground = #222\nforeground = #dfdfdf\n\n"};
+  size_t lines{4};
+  size_t sections{0};
+
+  for (size_t i = 0; lines < target; i++, sections++) {
+    contents += "[module/m" + to_string(i) + "]\n";
+    lines++;
+    if (i > 0) {
+      contents += "inherit = module/m" + to_string(i / 2) + "\n";
+      lines++;
+    }
+    for (size_t k = 0; k < 8; k++) {
+      contents += "key" + to_string(i) + "-" + to_string(k) + " = ${colors.foreground}\n";
+    }
+    contents += "format-background = ${colors.background}\n";
+    contents += "label = %name% " + to_string(i) + "\n\n";
+    lines += 11;
+  }
+  contents += "[bar/bench]\nmodules-left = m1 m2 m3\n";
+
+  char path[]{"/tmp/polybar_bench_config.XXXXXX"};
+  int fd{mkstemp(path)};
+
+  if (fd == -1) {
+    logger.err("Failed to create temporary config file");
+    return EXIT_FAILURE;
+  }
+
+  close(fd);
+  std::ofstream(path) << contents;
+
+  XInitThreads();
+  Display* xdisplay{XOpenDisplay(nullptr)};
+
+  if (xdisplay == nullptr) {
+    logger.err("A connection to X could not be established... ");
+    unlink(path);
+    return EXIT_FAILURE;
+  }
+
+  try {
+    connection::make(xdisplay);
+    const auto& xrm = xresource_manager::make();
+
+    auto load_us = time_util::measure<chrono::microseconds>([&] { config conf{logger, xrm, path, "bench"}; });
+
+    config conf{logger, xrm, path, "bench"};
+    size_t lookups{0};
+    size_t mismatches{0};
+
+    auto lookup_us = time_util::measure<chrono::microseconds>([&] {
+      for (size_t i = 0; i < sections; i++) {
+        string name{"module/m" + to_string(i)};
+        mismatches += conf.get<string>(name, "format-background") != "#222";
+        mismatches += conf.get<string>(name, "label", ""s) != "%name% " + to_string(i);
+        mismatches += conf.get_list<string>(name, "key" + to_string(i)).size() != 8;
+        mismatches += conf.get<int>(name, "missing", 0) != 0;
+        lookups += 4;
+      }
+    });
+
+    unlink(path);
+
+    if (mismatches != 0) {
+      logger.err("%zu lookups returned unexpected values", mismatches);
+      return EXIT_FAILURE;
+    }
+
+    printf("config: %zu lines, %zu sections\n", lines, sections);
+    printf("  load            %ld us\n", static_cast<long>(load_us));
+    printf("  lookups         %zu in %ld us\n", lookups, static_cast<long>(lookup_us));
+  } catch (const exception& err) {
+    logger.err("%s", err.what());
+    unlink(path);
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,139 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <numeric>
+
+#include "components/bar.hpp"
+#include "components/config.hpp"
+#include "components/logger.hpp"
+#include "x11/connection.hpp"
+
+using namespace polybar;
+
+namespace chrono = std::chrono;
+
+namespace {
+  /**
+   * Number of bytes written by the process so far,
+   * which includes everything sent over the X socket
+   */
+  size_t written_bytes() {
+    std::ifstream in{"/proc/self/io"};
+    string key;
+    size_t value{0};
+    while (in >> key >> value) {
+      if (key == "wchar:") {
+        return value;
+      }
+    }
+    return 0;
+  }
+
+  /**
+   * Wait until the server has processed all requests and return the
+   * sequence number of the last one (the sync request itself excluded)
+   */
+  unsigned int sync(connection& conn) {
+    auto cookie = xcb_get_input_focus(conn);
+    free(xcb_get_input_focus_reply(conn, cookie, nullptr));
+    return cookie.sequence - 1;
+  }
+
+  double percentile(const vector<double>& sorted, double p) {
+    if (sorted.empty()) {
+      return 0.0;
+    }
+    return sorted[std::min(sorted.size() - 1, static_cast<size_t>(p / 100.0 * sorted.size()))];
+  }
+}
+
+/**
+ * Feed recorded bar contents through bar::parse and bar::draw and report the cost of each frame
+ *
+ * Usage: bench.render CONFIG BAR DATAFILE [FRAMES]
+ */
+int main(int argc, char** argv) {
+  if (argc < 4) {
+    fprintf(stderr, "Usage: %s CONFIG BAR DATAFILE [FRAMES]\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  const logger& logger{logger::make(loglevel::ERROR)};
+
+  vector<shared_ptr<const string>> contents;
+  std::ifstream in{argv[3]};
+  for (string line; std::getline(in, line);) {
+    if (!line.empty()) {
+      contents.emplace_back(make_shared<const string>(move(line)));
+    }
+  }
+
+  if (contents.empty()) {
+    logger.err("No bar contents found in %s", argv[3]);
+    return EXIT_FAILURE;
+  }
+
+  size_t frames{argc > 4 ? std::strtoul(argv[4], nullptr, 10) : 1000UL};
+
+  if (frames == 0) {
+    logger.err("Invalid frame count: %s", argv[4]);
+    return EXIT_FAILURE;
+  }
+
+  XInitThreads();
+  Display* xdisplay{XOpenDisplay(nullptr)};
+
+  if (xdisplay == nullptr) {
+    logger.err("A connection to X could not be established... ");
+    return EXIT_FAILURE;
+  }
+
+  try {
+    connection& conn{connection::make(xdisplay)};
+    config::make(argv[1], argv[2]);
+
+    auto bar = bar::make(argv[2]);
+
+    // Warm up font and color caches before measuring
+    for (auto&& data : contents) {
+      bar->parse(data, true);
+      bar->draw();
+    }
+
+    vector<double> latency;
+    latency.reserve(frames);
+
+    size_t requests{0};
+    size_t bytes{0};
+
+    for (size_t i = 0; i < frames; i++) {
+      auto sequence = sync(conn);
+      auto written = written_bytes();
+      auto start = chrono::steady_clock::now();
+
+      bar->parse(contents[i % contents.size()], true);
+      bar->draw();
+      auto last = sync(conn);
+
+      latency.emplace_back(chrono::duration<double, std::milli>(chrono::steady_clock::now() - start).count());
+      requests += last - sequence - 1;
+      bytes += written_bytes() - written;
+    }
+
+    std::sort(latency.begin(), latency.end());
+
+    auto total = std::accumulate(latency.begin(), latency.end(), 0.0);
+
+    printf("%s: %zu frames, %zu distinct contents\n", argv[3], frames, contents.size());
+    printf("  latency (ms)    mean %.3f  p50 %.3f  p90 %.3f  p99 %.3f  max %.3f\n", total / frames,
+        percentile(latency, 50), percentile(latency, 90), percentile(latency, 99), latency.back());
+    printf("  per frame       %.1f requests  %.1f bytes written\n", static_cast<double>(requests) / frames,
+        static_cast<double>(bytes) / frames);
+  } catch (const exception& err) {
+    logger.err("%s", err.what());
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,44 @@
+#!/usr/bin/env bash
+#
+# Run a benchmark binary against a headless Xvfb instance
+#
+# Usage: run.sh BINARY [CONFIG DATAFILE...]
+#
+# Without a config the binary is run once without arguments
+#
+
+main() {
+  [[ $# -lt 1 || $# -eq 2 ]] && {
+    echo "Usage: ${0##*/} BINARY [CONFIG DATAFILE...]" >&2; exit 1
+  }
+
+  command -v Xvfb >/dev/null || {
+    echo "Xvfb is required to run the benchmarks" >&2; exit 1
+  }
+
+  local binary=$1 config=$2 display=:${BENCH_DISPLAY:-99} result=0
+  shift $(( $# > 1 ? 2 : 1 ))
+
+  Xvfb "$display" -screen 0 1920x1080x24 -nolisten tcp >/dev/null 2>&1 &
+  local xvfb=$!
+  trap 'kill $xvfb 2>/dev/null' EXIT
+
+  # Wait for the server to accept connections
+  for _ in {1..50}; do
+    [[ -e "/tmp/.X11-unix/X${display#:}" ]] && break
+    sleep 0.1
+  done
+
+  if [[ -z "$config" ]]; then
+    DISPLAY=$display "$binary"
+    return
+  fi
+
+  for data in "$@"; do
+    DISPLAY=$display "$binary" "$config" bench "$data" "${BENCH_FRAMES:-1000}" || result=1
+  done
+
+  return $result
+}
+
+main "$@"
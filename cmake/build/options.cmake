@@ -50,6 +50,7 @@ option(CXXLIB_GCC         "Link against stdlibc++"     OFF)
 
 option(BUILD_IPC_MSG      "Build ipc messager"         ON)
 option(BUILD_TESTS        "Build testsuite"            OFF)
+option(BUILD_BENCH        "Build benchmarks"           OFF)
 option(DEBUG_LOGGER       "Enable extra debug logging" OFF)
 option(DEBUG_LOGGER_TRACE "Enable verbose trace logs"  OFF)
 option(DEBUG_HINTS        "Enable hints rendering"     OFF)
@@ -67,7 +68,7 @@ option(ENABLE_MPD         "Enable mpd support"         ON)
 option(ENABLE_NETWORK     "Enable network support"     ON)
 
 option(WITH_XRANDR        "XRANDR support"             ON)
-option(WITH_XRENDER       "XRENDER support"            OFF)
+option(WITH_XRENDER       "XRENDER support"            ON)
 option(WITH_XDAMAGE       "XDAMAGE support"            OFF)
 option(WITH_XSYNC         "XSYNC support"              OFF)
 option(WITH_XCOMPOSITE    "XCOMPOSITE support"         OFF)
@@ -104,8 +105,8 @@ set(SETTING_PATH_CPU_INFO "/proc/stat"
   CACHE STRING "Path to file containing cpu info")
 set(SETTING_PATH_MEMORY_INFO "/proc/meminfo"
   CACHE STRING "Path to file containing memory info")
-set(SETTING_PATH_MESSAGING_FIFO "/tmp/polybar_mqueue.%pid%"
-  CACHE STRING "Path to file containing the current temperature")
+set(SETTING_PATH_MESSAGING_SOCKET "/tmp/polybar_mqueue.%pid%"
+  CACHE STRING "Path to the ipc socket")
 set(SETTING_PATH_TEMPERATURE_INFO "/sys/class/thermal/thermal_zone%zone%/temp"
   CACHE STRING "Path to file containing the current temperature")
 
@@ -55,6 +55,7 @@ endif()
 message(STATUS "--------------------------")
 colored_option(STATUS " Build polybar-msg    ${BUILD_IPC_MSG}" BUILD_IPC_MSG "32;1" "37;2")
 colored_option(STATUS " Build testsuite      ${BUILD_TESTS}" BUILD_TESTS "32;1" "37;2")
+colored_option(STATUS " Build benchmarks     ${BUILD_BENCH}" BUILD_BENCH "32;1" "37;2")
 colored_option(STATUS " Debug logging        ${DEBUG_LOGGER}" DEBUG_LOGGER "32;1" "37;2")
 colored_option(STATUS " + Verbose tracing    ${DEBUG_LOGGER_TRACE}" DEBUG_LOGGER_TRACE "32;1" "37;2")
 colored_option(STATUS " Draw debug hints     ${DEBUG_HINTS}" DEBUG_HINTS "32;1" "37;2")
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <array>
+
+#include "common.hpp"
+#include "components/types.hpp"
+
+POLYBAR_NS
+
+/**
+ * Immutable lookup table for the clickable areas of a rendered frame
+ *
+ * The completed action blocks are split into non-overlapping segments
+ * per mouse button, sorted by position. Each segment refers to the
+ * block that is hit at that position, which for nested blocks is the
+ * one that was opened first. Hit tests are a binary search over the
+ * segments of the button and do not allocate
+ */
+class action_index {
+ public:
+  static constexpr size_t BUTTONS{static_cast<size_t>(mousebtn::DOUBLE_RIGHT) + 1};
+
+  explicit action_index() = default;
+  explicit action_index(vector<action_block>&& blocks);
+
+  const action_block* find(mousebtn button, int16_t x) const;
+  bool has(mousebtn button) const;
+
+ protected:
+  /**
+   * Range of positions starting at `x` and ending at the start of the
+   * next segment, that is covered by the block `action` (or no block)
+   */
+  struct segment {
+    int32_t x;
+    size_t action;
+  };
+
+  static constexpr size_t NONE{static_cast<size_t>(-1)};
+
+ private:
+  vector<action_block> m_actions;
+  std::array<vector<segment>, BUTTONS> m_segments;
+};
+
+POLYBAR_NS_END
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <unordered_map>
+
+#include "common.hpp"
+
+POLYBAR_NS
+
+namespace modules {
+  class input_handler;
+}
+
+/**
+ * Dispatches input actions to the module that handles them
+ *
+ * Actions created by modules that handle input are prefixed with the id
+ * of the module ("#<id>.<command>") and passed directly to that module.
+ * Other actions, and actions declined by their module, are offered
+ * to each handler in turn. If no handler accepts the action it is
+ * left to the caller (e.g. to run it as a shell command)
+ */
+class action_router {
+ public:
+  static string prefix(size_t id);
+  static string strip(const string& action);
+
+  void add(size_t id, modules::input_handler* handler);
+  void clear();
+  bool dispatch(string& action) const;
+
+ protected:
+  static bool split(string& action, size_t& id);
+
+ private:
+  std::unordered_map<size_t, modules::input_handler*> m_routes;
+  vector<modules::input_handler*> m_handlers;
+};
+
+POLYBAR_NS_END
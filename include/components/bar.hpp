@@ -1,6 +1,7 @@
 #pragma once
 
 #include <atomic>
+#include <chrono>
 #include <mutex>
 
 #include "common.hpp"
@@ -29,19 +30,21 @@ class tray_manager;
 
 class bar : public xpp::event::sink<evt::button_press, evt::expose, evt::property_notify, evt::enter_notify,
                 evt::leave_notify, evt::destroy_notify, evt::client_message>,
-            public signal_receiver<SIGN_PRIORITY_BAR, signals::eventqueue::start, signals::ui::tick, signals::ui::shade_window, signals::ui::unshade_window,
-                signals::ui::dim_window> {
+            public signal_receiver<SIGN_PRIORITY_BAR, signals::eventqueue::start> {
  public:
   using make_type = unique_ptr<bar>;
-  static make_type make(bool only_initialize_values = false);
+  static make_type make(string name, bool only_initialize_values = false);
 
   explicit bar(connection&, signal_emitter&, const config&, const logger&, unique_ptr<screen>&&,
-      unique_ptr<tray_manager>&&, unique_ptr<parser>&&, unique_ptr<taskqueue>&&, bool only_initialize_values);
+      unique_ptr<tray_manager>&&, unique_ptr<parser>&&, unique_ptr<taskqueue>&&, string&& name,
+      bool only_initialize_values);
   ~bar();
 
-  const bar_settings settings() const;
+  string section() const;
+  shared_ptr<const bar_settings> settings() const;
 
-  void parse(string&& data, bool force = false);
+  void parse(shared_ptr<const string> data, bool force = false);
+  void draw();
 
  protected:
   void restack_window();
@@ -49,6 +52,14 @@ class bar : public xpp::event::sink<evt::button_press, evt::expose, evt::propert
   void reconfigure_struts();
   void reconfigure_wm_hints();
   void broadcast_visibility();
+  void publish_settings();
+  void render(const shared_ptr<const string>& data, bool force);
+
+  void shade();
+  void unshade();
+  void animate(std::chrono::milliseconds delay);
+  void tick();
+  void dim(double opacity);
 
   void handle(const evt::client_message& evt);
   void handle(const evt::destroy_notify& evt);
@@ -59,10 +70,6 @@ class bar : public xpp::event::sink<evt::button_press, evt::expose, evt::propert
   void handle(const evt::property_notify& evt);
 
   bool on(const signals::eventqueue::start&);
-  bool on(const signals::ui::unshade_window&);
-  bool on(const signals::ui::shade_window&);
-  bool on(const signals::ui::tick&);
-  bool on(const signals::ui::dim_window&);
 
  private:
   connection& m_connection;
@@ -75,10 +82,25 @@ class bar : public xpp::event::sink<evt::button_press, evt::expose, evt::propert
   unique_ptr<parser> m_parser{};
   unique_ptr<taskqueue> m_taskqueue;
 
+  const string m_section;
   bar_settings m_opts{};
 
-  string m_lastinput{};
+  /**
+   * Snapshot of m_opts handed out to readers, replaced
+   * (never modified) whenever the settings change
+   */
+  shared_ptr<const bar_settings> m_settings{};
+
+  shared_ptr<const string> m_lastinput{};
   std::mutex m_mutex{};
+
+  /**
+   * Latest input passed to parse() that has not been drawn yet
+   */
+  std::mutex m_pendinglock{};
+  shared_ptr<const string> m_pending{};
+  bool m_pendingforce{false};
+  bool m_haspending{false};
   std::atomic<bool> m_dblclicks{false};
 
   mousebtn m_buttonpress_btn{mousebtn::NONE};
@@ -87,7 +109,18 @@ class bar : public xpp::event::sink<evt::button_press, evt::expose, evt::propert
   event_timer m_buttonpress{0L, 5L};
   event_timer m_doubleclick{0L, 150L};
 
-  double m_anim_step{0};
+  /**
+   * State of the shade animation, including the window
+   * geometry as last configured by the bar
+   */
+  struct shade_animation {
+    std::chrono::steady_clock::time_point start{};
+    std::chrono::duration<double> duration{0.25};
+    int16_t from_y{0};
+    uint16_t from_h{0U};
+    int16_t y{0};
+    uint16_t h{0U};
+  } m_anim{};
 };
 
 POLYBAR_NS_END
@@ -51,6 +51,7 @@ class builder {
   void overline_close();
   void underline(const string& color = "");
   void underline_close();
+  void cmd_prefix(string prefix);
   void cmd(mousebtn index, string action, bool condition = true);
   void cmd(mousebtn index, string action, const label_t& label);
   void cmd_close(bool condition = true);
@@ -65,7 +66,7 @@ class builder {
   void tag_close(attribute attr);
 
  private:
-  const bar_settings m_bar;
+  const bar_settings& m_bar;
   string m_output;
 
   map<syntaxtag, int> m_tags{};
@@ -76,6 +77,7 @@ class builder {
 
   string m_background{};
   string m_foreground{};
+  string m_cmdprefix{};
 };
 
 POLYBAR_NS_END
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <mutex>
+#include <shared_mutex>
 #include <unordered_map>
 
 #include "common.hpp"
@@ -17,8 +19,29 @@ DEFINE_ERROR(key_error);
 
 class config {
  public:
-  using valuemap_t = std::unordered_map<string, string>;
+  /**
+   * @brief Parameter value
+   *
+   * References (${section.key}, ${env:..}, ${xrdb:..}, ${file:..}) are
+   * resolved once after the file has been parsed and values converted
+   * to a given type are cached
+   */
+  struct entry {
+    enum class state : uint8_t { UNRESOLVED = 0, RESOLVING, RESOLVED };
+
+    explicit entry(string&& raw = "") : raw(forward<string>(raw)) {}
+
+    string raw;
+    string value;
+    string error;
+    state status{state::UNRESOLVED};
+    mutable std::unordered_map<const void*, shared_ptr<const void>> cache;
+  };
+
+  using valuemap_t = std::unordered_map<string, entry>;
   using sectionmap_t = std::unordered_map<string, valuemap_t>;
+  using listmap_t = std::unordered_map<string, std::unordered_map<string, vector<const entry*>>>;
+  using diff_t = std::unordered_map<string, vector<string>>;
 
   using make_type = const config&;
   static make_type make(string path = "", string bar = "");
@@ -31,31 +54,24 @@ class config {
   void warn_deprecated(const string& section, const string& key, string replacement) const;
 
   /**
-   * Returns true if a given parameter exists
+   * Returns true if a given section exists
    */
-  bool has(const string& section, const string& key) const {
-    auto it = m_sections.find(section);
-    return it != m_sections.end() && it->second.find(key) != it->second.end();
+  bool has_section(const string& section) const {
+    std::shared_lock<std::shared_timed_mutex> guard(m_lock);
+    return m_sections.find(section) != m_sections.end();
   }
 
   /**
-   * Set parameter value
+   * Returns true if a given parameter exists
    */
-  void set(const string& section, const string& key, string&& value) {
-    auto it = m_sections.find(section);
-    if (it == m_sections.end()) {
-      valuemap_t values;
-      values[key] = value;
-      m_sections[section] = move(values);
-    }
-    auto it2 = it->second.find(key);
-    if ((it2 = it->second.find(key)) == it->second.end()) {
-      it2 = it->second.emplace_hint(it2, key, value);
-    } else {
-      it2->second = value;
-    }
+  bool has(const string& section, const string& key) const {
+    std::shared_lock<std::shared_timed_mutex> guard(m_lock);
+    return find(section, key) != nullptr;
   }
 
+  void set(const string& section, const string& key, string&& value);
+  diff_t reload();
+
   /**
    * Get parameter for the current bar by name
    */
@@ -69,11 +85,12 @@ class config {
    */
   template <typename T = string>
   T get(const string& section, const string& key) const {
-    auto it = m_sections.find(section);
-    if (it == m_sections.end() || it->second.find(key) == it->second.end()) {
+    std::shared_lock<std::shared_timed_mutex> guard(m_lock);
+    const entry* e{find(section, key)};
+    if (e == nullptr) {
       throw key_error("Missing parameter [" + section + "." + key + "]");
     }
-    return dereference<T>(section, key, it->second.at(key), convert<T>(string{it->second.at(key)}));
+    return value<T>(*e);
   }
 
   /**
@@ -82,13 +99,9 @@ class config {
    */
   template <typename T = string>
   T get(const string& section, const string& key, const T& default_value) const {
-    try {
-      string string_value{get<string>(section, key)};
-      T result{convert<T>(string{string_value})};
-      return dereference<T>(move(section), move(key), move(string_value), move(result));
-    } catch (const key_error& err) {
-      return default_value;
-    }
+    std::shared_lock<std::shared_timed_mutex> guard(m_lock);
+    const entry* e{find(section, key)};
+    return e != nullptr ? value<T>(*e) : default_value;
   }
 
   /**
@@ -104,22 +117,7 @@ class config {
    */
   template <typename T = string>
   vector<T> get_list(const string& section, const string& key) const {
-    vector<T> results;
-
-    while (true) {
-      try {
-        string string_value{get<string>(section, key + "-" + to_string(results.size()))};
-        T value{convert<T>(string{string_value})};
-
-        if (!string_value.empty()) {
-          results.emplace_back(dereference<T>(section, key, move(string_value), move(value)));
-        } else {
-          results.emplace_back(move(value));
-        }
-      } catch (const key_error& err) {
-        break;
-      }
-    }
+    vector<T> results{get_list<T>(section, key, vector<T>{})};
 
     if (results.empty()) {
       throw key_error("Missing parameter [" + section + "." + key + "-0]");
@@ -134,29 +132,21 @@ class config {
    */
   template <typename T = string>
   vector<T> get_list(const string& section, const string& key, const vector<T>& default_value) const {
-    vector<T> results;
+    std::shared_lock<std::shared_timed_mutex> guard(m_lock);
+    const vector<const entry*>* entries{find_list(section, key)};
 
-    while (true) {
-      try {
-        string string_value{get<string>(section, key + "-" + to_string(results.size()))};
-        T value{convert<T>(string{string_value})};
-
-        if (!string_value.empty()) {
-          results.emplace_back(dereference<T>(section, key, move(string_value), move(value)));
-        } else {
-          results.emplace_back(move(value));
-        }
-      } catch (const key_error& err) {
-        break;
-      }
+    if (entries == nullptr) {
+      return default_value;
     }
 
-    if (!results.empty()) {
-      return results;
-      ;
+    vector<T> results;
+    results.reserve(entries->size());
+
+    for (auto&& e : *entries) {
+      results.emplace_back(value<T>(*e));
     }
 
-    return default_value;
+    return results;
   }
 
   /**
@@ -192,119 +182,50 @@ class config {
  protected:
   void parse_file();
   void copy_inherited();
+  void copy_inherited(const string& section, std::unordered_map<string, bool>& visited);
+  void resolve_all();
+  void index_lists();
+  void index_lists(const string& section);
+
+  const entry* find(const string& section, const string& key) const;
+  const vector<const entry*>* find_list(const string& section, const string& key) const;
+
+  void resolve(const string& section, const string& key, entry& e);
+  const entry* referenced(const string& section, const string& raw) const;
+  string reference_section(string section, const string& current_section) const;
+  string dereference(const string& section, const string& key, const string& var);
+  string dereference_local(string section, const string& key, const string& current_section);
+  string dereference_env(string var) const;
+  string dereference_xrdb(string var, const string& fallback) const;
+  string dereference_file(string var, const string& fallback) const;
 
   template <typename T>
   T convert(string&& value) const;
 
   /**
-   * Dereference value reference
-   */
-  template <typename T>
-  T dereference(const string& section, const string& key, const string& var, const T& fallback) const {
-    if (var.substr(0, 2) != "${" || var.substr(var.length() - 1) != "}") {
-      return fallback;
-    }
-
-    auto path = var.substr(2, var.length() - 3);
-    size_t pos;
-
-    if (path.compare(0, 4, "env:") == 0) {
-      return dereference_env<T>(path.substr(4), fallback);
-    } else if (path.compare(0, 5, "xrdb:") == 0) {
-      return dereference_xrdb<T>(path.substr(5), fallback);
-    } else if (path.compare(0, 5, "file:") == 0) {
-      return dereference_file<T>(path.substr(5), fallback);
-    } else if ((pos = path.find(".")) != string::npos) {
-      return dereference_local<T>(path.substr(0, pos), path.substr(pos + 1), section);
-    } else {
-      throw value_error("Invalid reference defined at [" + section + "." + key + "]");
-    }
-  }
-
-  /**
-   * Dereference local value reference defined using:
-   *  ${root.key}
-   *  ${self.key}
-   *  ${section.key}
+   * Unique tag used as cache key for converted values
    */
   template <typename T>
-  T dereference_local(string section, const string& key, const string& current_section) const {
-    if (section == "BAR") {
-      m_log.warn("${BAR.key} is deprecated. Use ${root.key} instead");
-    }
-
-    section = string_util::replace(section, "BAR", this->section(), 0, 3);
-    section = string_util::replace(section, "root", this->section(), 0, 4);
-    section = string_util::replace(section, "self", current_section, 0, 4);
-
-    try {
-      string string_value{get<string>(section, key)};
-      T result{convert<T>(string{string_value})};
-      return dereference<T>(string(section), move(key), move(string_value), move(result));
-    } catch (const key_error& err) {
-      throw value_error("Unexisting reference defined [" + section + "." + key + "]");
-    }
+  static const void* type_tag() {
+    static const char tag{0};
+    return &tag;
   }
 
   /**
-   * Dereference environment variable reference defined using:
-   *  ${env:key}
-   *  ${env:key:fallback value}
+   * Get the resolved value converted to given type
    */
   template <typename T>
-  T dereference_env(string var, const T&) const {
-    size_t pos;
-    string env_default{""};
-
-    if ((pos = var.find(":")) != string::npos) {
-      env_default = var.substr(pos + 1);
-      var.erase(pos);
+  T value(const entry& e) const {
+    if (!e.error.empty()) {
+      throw value_error(e.error);
     }
 
-    if (env_util::has(var.c_str())) {
-      string env_value{env_util::get(var.c_str())};
-      m_log.info("Found matching environment variable ${" + var + "} with the value \"" + env_value + "\"");
-      return convert<T>(move(env_value));
-    } else if (!env_default.empty()) {
-      m_log.info("The environment variable ${" + var + "} is undefined or empty, using defined fallback value \"" +
-                 env_default + "\"");
-    } else {
-      m_log.info("The environment variable ${" + var + "} is undefined or empty");
+    std::lock_guard<std::mutex> guard(m_cachelock);
+    auto& cached = e.cache[type_tag<T>()];
+    if (!cached) {
+      cached = make_shared<const T>(convert<T>(string{e.value}));
     }
-
-    return convert<T>(move(env_default));
-  }
-
-  /**
-   * Dereference X resource db value defined using:
-   *  ${xrdb:key}
-   *  ${xrdb:key:fallback value}
-   */
-  template <typename T>
-  T dereference_xrdb(string var, const T& fallback) const {
-    size_t pos;
-
-    if ((pos = var.find(":")) != string::npos) {
-      return convert<T>(m_xrm.get_string(var.substr(0, pos), var.substr(pos + 1)));
-    }
-
-    string str{m_xrm.get_string(var, "")};
-    return str.empty() ? fallback : convert<T>(move(str));
-  }
-
-  /**
-   * Dereference file reference by reading its contents
-   *  ${file:/absolute/file/path}
-   */
-  template <typename T>
-  T dereference_file(string var, const T& fallback) const {
-    string filename{move(var)};
-
-    if (file_util::exists(filename)) {
-      return convert<T>(string_util::trim(file_util::contents(filename), '\n'));
-    }
-
-    return fallback;
+    return *std::static_pointer_cast<const T>(cached);
   }
 
  private:
@@ -314,6 +235,26 @@ class config {
   string m_file;
   string m_barname;
   sectionmap_t m_sections{};
+  listmap_t m_lists{};
+  mutable std::shared_timed_mutex m_lock;
+  mutable std::mutex m_cachelock;
 };
 
+/**
+ * Strings are returned as is, without going through the cache
+ */
+template <>
+inline string config::value(const entry& e) const {
+  if (!e.error.empty()) {
+    throw value_error(e.error);
+  }
+  return e.value;
+}
+
+/**
+ * Raw pointers would not survive a reload, request a string instead
+ */
+template <>
+const char* config::value(const entry& e) const = delete;
+
 POLYBAR_NS_END
@@ -1,9 +1,11 @@
 #pragma once
 
-#include <moodycamel/blockingconcurrentqueue.h>
+#include <condition_variable>
+#include <mutex>
 #include <thread>
 
 #include "common.hpp"
+#include "components/action_router.hpp"
 #include "settings.hpp"
 #include "events/signal_fwd.hpp"
 #include "events/signal_receiver.hpp"
@@ -18,19 +20,21 @@ POLYBAR_NS
 
 enum class alignment : uint8_t;
 class bar;
+struct bar_settings;
 class command;
 class config;
 class connection;
+class eventqueue;
 class inotify_watch;
 class ipc;
 class logger;
 class signal_emitter;
 namespace modules {
   struct module_interface;
-  class input_handler;
 }
-using module_t = unique_ptr<modules::module_interface>;
-using modulemap_t = std::map<alignment, vector<module_t>>;
+using module_t = shared_ptr<modules::module_interface>;
+using modulemap_t = std::map<string, module_t>;
+using layout_t = std::map<alignment, vector<modules::module_interface*>>;
 
 // }}}
 
@@ -39,10 +43,10 @@ class controller : public signal_receiver<SIGN_PRIORITY_CONTROLLER, signals::eve
                        signals::ipc::command, signals::ipc::hook, signals::ui::button_press> {
  public:
   using make_type = unique_ptr<controller>;
-  static make_type make(unique_ptr<ipc>&& ipc, unique_ptr<inotify_watch>&& config_watch);
+  static make_type make(const vector<string>& bars, unique_ptr<ipc>&& ipc, unique_ptr<inotify_watch>&& config_watch);
 
-  explicit controller(connection&, signal_emitter&, const logger&, const config&, unique_ptr<bar>&&, unique_ptr<ipc>&&,
-      unique_ptr<inotify_watch>&&);
+  explicit controller(connection&, signal_emitter&, const logger&, const config&, vector<unique_ptr<bar>>&&,
+      unique_ptr<ipc>&&, unique_ptr<inotify_watch>&&);
   ~controller();
 
   bool run(bool writeback = false);
@@ -51,10 +55,21 @@ class controller : public signal_receiver<SIGN_PRIORITY_CONTROLLER, signals::eve
   bool enqueue(string&& input_data);
 
  protected:
+  modulemap_t setup_modules(const vector<string>& changed, vector<modules::module_interface*>& created);
+  size_t start_modules(const vector<modules::module_interface*>& modules);
+  void stop_modules(modulemap_t&& modules);
+  bool reconfigure();
+
   void read_events();
   void process_eventqueue();
+  void process_renderqueue();
+  void stop_rendering();
   void process_inputdata();
   bool process_update(bool force);
+  vector<shared_ptr<const string>> collect_contents(const layout_t& layout);
+  string build_contents(const bar_settings& bar, const layout_t& layout,
+      const vector<shared_ptr<const string>>& segments);
+  void process_check();
 
   bool on(const signals::eventqueue::notify_change& evt);
   bool on(const signals::eventqueue::notify_forcechange& evt);
@@ -71,7 +86,7 @@ class controller : public signal_receiver<SIGN_PRIORITY_CONTROLLER, signals::eve
   signal_emitter& m_sig;
   const logger& m_log;
   const config& m_conf;
-  unique_ptr<bar> m_bar;
+  vector<unique_ptr<bar>> m_bars;
   unique_ptr<ipc> m_ipc;
   unique_ptr<inotify_watch> m_confwatch;
   unique_ptr<command> m_command;
@@ -86,27 +101,34 @@ class controller : public signal_receiver<SIGN_PRIORITY_CONTROLLER, signals::eve
   /**
    * @brief Internal event queue
    */
-  moodycamel::BlockingConcurrentQueue<event> m_queue;
+  unique_ptr<eventqueue> m_queue;
 
   /**
-   * @brief Loaded modules
+   * @brief Loaded modules, shared by all bars
    */
   modulemap_t m_modules;
 
   /**
-   * @brief Module input handlers
+   * @brief Modules shown by each bar
+   */
+  vector<layout_t> m_layouts;
+
+  /**
+   * @brief Module output each bar was last built from, bars are
+   * only rebuilt once one of their modules published a new buffer
    */
-  vector<modules::input_handler*> m_inputhandlers;
+  vector<vector<shared_ptr<const string>>> m_segments;
 
   /**
-   * @brief Maximum number of subsequent events to swallow
+   * @brief Guards the loaded modules while they are replaced
+   * on reload (they are only modified by the main thread)
    */
-  size_t m_swallow_limit{5U};
+  std::mutex m_modulelock;
 
   /**
-   * @brief Time to wait for subsequent events
+   * @brief Routes input actions to the module input handlers
    */
-  std::chrono::milliseconds m_swallow_update{10};
+  action_router m_router;
 
   /**
    * @brief Time to throttle input events
@@ -127,6 +149,15 @@ class controller : public signal_receiver<SIGN_PRIORITY_CONTROLLER, signals::eve
    * @brief Thread for the eventqueue loop
    */
   std::thread m_event_thread;
+
+  /**
+   * @brief Thread drawing the bars, woken when new contents are queued
+   */
+  std::thread m_render_thread;
+  std::mutex m_renderlock;
+  std::condition_variable m_rendercond;
+  bool m_renderpending{false};
+  bool m_renderstop{false};
 };
 
 POLYBAR_NS_END
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+
+#include "common.hpp"
+#include "events/types.hpp"
+#include "utils/mixins.hpp"
+
+POLYBAR_NS
+
+namespace chrono = std::chrono;
+
+/**
+ * Event queue that collapses redundant events
+ *
+ * QUIT and INPUT events have their own lanes and are handed out
+ * before anything else. UPDATE events only mark the output as dirty
+ * and bump a generation counter, so any number of updates arriving
+ * before the next redraw result in a single UPDATE event. Redraws are
+ * paced to a maximum frame rate: an update is handed out right away if
+ * the previous one is older than the frame interval and delayed until
+ * the interval has passed otherwise.
+ */
+class eventqueue : non_copyable_mixin<eventqueue> {
+ public:
+  using clock = chrono::steady_clock;
+  using duration = chrono::microseconds;
+
+  using make_type = unique_ptr<eventqueue>;
+  static make_type make(duration frame_interval = duration::zero());
+
+  explicit eventqueue(duration frame_interval);
+
+  void push(event&& evt);
+  bool pop(event& evt);
+  void close();
+
+  size_t generation() const;
+  size_t coalesced() const;
+
+ protected:
+  bool next(event& evt, clock::time_point now, clock::time_point& wakeup);
+
+ private:
+  const duration m_interval;
+
+  mutable std::mutex m_lock;
+  std::condition_variable m_cond;
+  bool m_closed{false};
+
+  bool m_quit{false};
+  bool m_reload{false};
+  size_t m_input{0};
+  bool m_check{false};
+
+  bool m_dirty{false};
+  bool m_force{false};
+  size_t m_generation{0};
+  size_t m_coalesced{0};
+  clock::time_point m_lastframe{};
+};
+
+POLYBAR_NS_END
@@ -1,6 +1,8 @@
 #pragma once
 
 #include "common.hpp"
+#include "events/signal_fwd.hpp"
+#include "events/signal_receiver.hpp"
 #include "settings.hpp"
 #include "utils/concurrency.hpp"
 
@@ -25,15 +27,41 @@ struct ipc_action {
   static constexpr const char* prefix{"action:"};
   char payload[EVENT_SIZE]{'\0'};
 };
+struct ipc_stats {
+  static constexpr const char* prefix{"stats"};
+};
+struct ipc_subscribe {
+  static constexpr const char* prefix{"subscribe"};
+};
+struct ipc_event {
+  static constexpr const char* prefix{"event:"};
+};
+
+/**
+ * Status codes sent back for each request
+ */
+enum class ipc_status : uint8_t {
+  OK = 0,
+  UNKNOWN_TYPE,
+  REJECTED,
+  TOO_LONG,
+};
 
 /**
  * Component used for inter-process communication.
  *
- * A unique messaging channel will be setup for each
- * running process which will allow messages and
- * events to be sent to the process externally.
+ * A unique unix socket (SOCK_SEQPACKET) will be setup for each
+ * running process which will allow messages and events to be sent
+ * to the process externally. Any number of clients can stay connected.
+ *
+ * Each packet holds one or more requests, separated by newlines.
+ * The reply is a single packet with one "<status> <text>" line per
+ * request. Data produced by the requests (stats) follows after an
+ * empty line. Clients that sent "subscribe" additionally receive
+ * "event:<name>:<value>" packets for bar events.
  */
-class ipc {
+class ipc : public signal_receiver<SIGN_PRIORITY_IPC, signals::ui::button_press, signals::ui::visibility_change,
+                signals::ui::shade_window, signals::ui::unshade_window> {
  public:
   using make_type = unique_ptr<ipc>;
   static make_type make();
@@ -41,8 +69,24 @@ class ipc {
   explicit ipc(signal_emitter& emitter, const logger& logger);
   ~ipc();
 
-  void receive_message();
-  int get_file_descriptor() const;
+  vector<int> get_file_descriptors() const;
+  void receive_message(int fd);
+
+ protected:
+  struct client {
+    unique_ptr<file_descriptor> fd;
+    bool subscribed{false};
+  };
+
+  void accept_clients();
+  void disconnect(int fd);
+  string process(const string& message, bool& subscribe);
+  void publish(const string& name, const string& value);
+
+  bool on(const signals::ui::button_press& evt);
+  bool on(const signals::ui::visibility_change& evt);
+  bool on(const signals::ui::shade_window& evt);
+  bool on(const signals::ui::unshade_window& evt);
 
  private:
   signal_emitter& m_sig;
@@ -50,6 +94,9 @@ class ipc {
 
   string m_path{};
   unique_ptr<file_descriptor> m_fd{};
+
+  mutable std::mutex m_mutex;
+  vector<client> m_clients;
 };
 
 POLYBAR_NS_END
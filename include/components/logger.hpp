@@ -1,7 +1,10 @@
 #pragma once
 
+#include <array>
+#include <atomic>
+#include <condition_variable>
 #include <cstdio>
-#include <map>
+#include <mutex>
 #include <string>
 #include <thread>
 
@@ -24,17 +27,28 @@ enum class loglevel : uint8_t {
   TRACE,
 };
 
+/**
+ * Non-blocking logger
+ *
+ * Messages are formatted into a fixed size ring buffer by the
+ * calling thread and written to the output by a background thread.
+ * If the buffer is full the message is dropped and counted
+ */
 class logger {
  public:
   using make_type = const logger&;
   static make_type make(loglevel level = loglevel::NONE);
 
-  explicit logger(loglevel level);
+  explicit logger(loglevel level, int fd = STDERR_FILENO);
+  ~logger();
 
   static loglevel parse_verbosity(const string& name, loglevel fallback = loglevel::NONE);
 
   void verbosity(loglevel&& level);
 
+  void flush() const;
+  size_t dropped() const;
+
 #ifdef DEBUG_LOGGER  // {{{
   template <typename... Args>
   void trace(string message, Args... args) const {
@@ -89,7 +103,8 @@ class logger {
   /**
    * Convert string
    */
-  const char* convert(string arg) const;  // NOLINT
+  const char* convert(string& arg) const;
+  const char* convert(const string& arg) const;
 
   /**
    * Convert thread id
@@ -97,15 +112,20 @@ class logger {
   size_t convert(const std::thread::id arg) const;
 
   /**
-   * Write the log message to the output channel
+   * Format the log message into the ring buffer
    * if the defined verbosity level allows it
    */
   template <typename... Args>
-  void output(loglevel level, string format, Args... values) const {
+  void output(loglevel level, const string& format, Args... values) const {
     if (level > m_level) {
       return;
     }
 
+    slot* s{acquire()};
+    if (s == nullptr) {
+      return;
+    }
+
 #if defined(__clang__)  // {{{
 #pragma clang diagnostic push
 #pragma clang diagnostic ignored "-Wformat-security"
@@ -114,15 +134,41 @@ class logger {
 #pragma GCC diagnostic ignored "-Wformat-security"
 #endif  // }}}
 
-    dprintf(m_fd, (m_prefixes.at(level) + format + m_suffixes.at(level) + "\n").c_str(), convert(values)...);
+    int len{snprintf(s->text, sizeof(s->text), format.c_str(), convert(values)...)};
 
 #if defined(__clang__)  // {{{
 #pragma clang diagnostic pop
 #elif defined(__GNUC__)
 #pragma GCC diagnostic pop
 #endif  // }}}
+
+    publish(s, level, len);
   }
 
+ private:
+  static constexpr size_t BUFFER_SLOTS{512};
+  static constexpr size_t SLOT_SIZE{512};
+
+  /**
+   * @brief Ring buffer slot
+   *
+   * The sequence number tells which lap of the ring the slot
+   * is ready for: seq == pos when it can be written and
+   * seq == pos + 1 when it holds a message
+   */
+  struct slot {
+    std::atomic<size_t> seq;
+    loglevel level;
+    size_t length;
+    char text[SLOT_SIZE];
+  };
+
+  slot* acquire() const;
+  void publish(slot* s, loglevel level, int length) const;
+  void flusher();
+  bool write_pending();
+  void write_line(loglevel level, const char* text, size_t length);
+
  private:
   /**
    * Logger verbosity level
@@ -135,14 +181,45 @@ class logger {
   int m_fd{STDERR_FILENO};
 
   /**
-   * Loglevel specific prefixes
+   * Loglevel specific prefixes, indexed by level
+   */
+  array<string, 5> m_prefixes;
+
+  /**
+   * Loglevel specific suffixes, indexed by level
    */
-  std::map<loglevel, string> m_prefixes;
+  array<string, 5> m_suffixes;
 
   /**
-   * Loglevel specific suffixes
+   * Message slots shared between the producers and the writer
    */
-  std::map<loglevel, string> m_suffixes;
+  unique_ptr<slot[]> m_slots;
+
+  /**
+   * Next position to be claimed by a producer
+   */
+  mutable std::atomic<size_t> m_enqueue_pos{0};
+
+  /**
+   * Next position to be written by the writer thread
+   */
+  std::atomic<size_t> m_dequeue_pos{0};
+
+  /**
+   * Number of messages dropped because the buffer was full
+   */
+  mutable std::atomic<size_t> m_dropped{0};
+
+  /**
+   * Number of dropped messages already reported
+   */
+  size_t m_dropped_reported{0};
+
+  mutable std::mutex m_waitlock;
+  mutable std::condition_variable m_wakeup;
+  mutable std::condition_variable m_drained;
+  std::atomic<bool> m_running{true};
+  std::thread m_thread;
 };
 
 POLYBAR_NS_END
@@ -0,0 +1,119 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+
+#include "common.hpp"
+
+POLYBAR_NS
+
+namespace chrono = std::chrono;
+
+/**
+ * Runtime counters and timing histograms collected in the hot paths
+ * (reported by `polybar-msg stats`)
+ *
+ * Counters are shared atomics. Timings are recorded into a histogram owned
+ * by the calling thread, so recording never contends with other threads.
+ * The per-thread histograms are merged when a report is requested.
+ *
+ * Metrics are registered by name and addressed by the returned id,
+ * registering an existing name returns the same id
+ */
+class metrics {
+ public:
+  using clock = chrono::steady_clock;
+
+  static constexpr size_t MAX_METRICS{128};
+
+  /**
+   * Timings are bucketed by powers of two microseconds,
+   * the last bucket holds everything above 2^(BUCKETS-2) us
+   */
+  static constexpr size_t BUCKETS{20};
+
+  /**
+   * Id returned once all slots are taken, recording to it is a no-op
+   */
+  static constexpr size_t INVALID{MAX_METRICS};
+
+  struct timing {
+    std::atomic<uint64_t> count{0};
+    std::atomic<uint64_t> sum{0};
+    std::atomic<uint64_t> max{0};
+    std::array<std::atomic<uint64_t>, BUCKETS> buckets{};
+  };
+
+  struct summary {
+    string name;
+    uint64_t count;
+    uint64_t sum;
+    uint64_t max;
+    std::array<uint64_t, BUCKETS> buckets;
+
+    uint64_t percentile(double p) const;
+  };
+
+  /**
+   * Records the time spent between construction and
+   * destruction of the probe
+   */
+  class probe {
+   public:
+    explicit probe(metrics& m, size_t id) : m_metrics(m), m_id(id), m_start(clock::now()) {}
+    ~probe() {
+      m_metrics.record(m_id, clock::now() - m_start);
+    }
+
+   private:
+    metrics& m_metrics;
+    size_t m_id;
+    clock::time_point m_start;
+  };
+
+ public:
+  using make_type = metrics&;
+  static make_type make();
+
+  explicit metrics();
+
+  size_t counter(const string& name);
+  size_t timer(const string& name);
+
+  void increment(size_t id, uint64_t n = 1);
+  void record(size_t id, clock::duration elapsed);
+
+  uint64_t count(size_t id) const;
+  summary timings(size_t id) const;
+  string report() const;
+
+ protected:
+  struct shard {
+    explicit shard(metrics& m);
+    ~shard();
+
+    metrics& owner;
+    std::array<timing, MAX_METRICS> timings;
+  };
+
+  shard& local();
+
+ private:
+  const clock::time_point m_origin;
+
+  mutable std::mutex m_mutex;
+  vector<string> m_counter_names;
+  vector<string> m_timer_names;
+  std::array<std::atomic<uint64_t>, MAX_METRICS> m_counters{};
+
+  /**
+   * Histograms of running threads, and the sum of
+   * histograms of threads that have exited
+   */
+  vector<shard*> m_shards;
+  unique_ptr<std::array<timing, MAX_METRICS>> m_retired;
+};
+
+POLYBAR_NS_END
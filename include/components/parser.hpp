@@ -1,5 +1,7 @@
 #pragma once
 
+#include <unordered_map>
+
 #include "common.hpp"
 #include "errors.hpp"
 
@@ -17,8 +19,12 @@ DEFINE_CHILD_ERROR(unclosed_actionblocks, parser_error);
 
 class parser {
  public:
+  /**
+   * Decoded code points of a text span. The data is owned by
+   * the parser and only valid while the signal is handled
+   */
   struct packet {
-    uint16_t data[128]{0U};
+    const uint32_t* data{nullptr};
     size_t length{0};
   };
   using make_type = unique_ptr<parser>;
@@ -38,9 +44,29 @@ class parser {
   mousebtn parse_action_btn(const string& data);
   string parse_action_cmd(string&& data);
 
+  /**
+   * Result of parsing a color string, premultiplied once
+   */
+  struct parsed_color {
+    bool valid;
+    uint32_t value;
+    uint32_t premultiplied;
+  };
+
  private:
   signal_emitter& m_sig;
   vector<int> m_actions;
+
+  /**
+   * Colors seen in format tags, bounded since they may be
+   * generated by scripts without any limit
+   */
+  std::unordered_map<string, parsed_color> m_colors;
+
+  /**
+   * Reused buffer holding the code points of the current text span
+   */
+  vector<uint32_t> m_text;
   unique_ptr<parser> m_parser;
 };
 
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+
+#include "common.hpp"
+
+#ifndef STDERR_FILENO
+#define STDERR_FILENO 2
+#endif
+
+POLYBAR_NS
+
+namespace chrono = std::chrono;
+
+/**
+ * Collects wall-clock timings of named startup phases
+ * (used by --profile-startup)
+ *
+ * Recording is a no-op until the profiler has been enabled
+ * and is safe to call from multiple threads
+ */
+class profiler {
+ public:
+  using clock = chrono::steady_clock;
+  using duration = chrono::microseconds;
+
+  struct entry {
+    string phase;
+    duration offset;
+    duration elapsed;
+  };
+
+  /**
+   * Records the time spent between construction and
+   * destruction of the probe
+   */
+  class probe {
+   public:
+    explicit probe(profiler& p, string&& phase) : m_profiler(p), m_phase(move(phase)), m_start(clock::now()) {}
+    ~probe() {
+      m_profiler.record(move(m_phase), m_start, clock::now());
+    }
+
+   private:
+    profiler& m_profiler;
+    string m_phase;
+    clock::time_point m_start;
+  };
+
+ public:
+  using make_type = profiler&;
+  static make_type make();
+
+  explicit profiler();
+
+  void enable();
+  bool enabled() const;
+
+  void record(string&& phase, clock::time_point start, clock::time_point end);
+  vector<entry> entries() const;
+  void report(int fd = STDERR_FILENO) const;
+
+  /**
+   * Run given function and record the time it took
+   */
+  template <typename Fn>
+  decltype(auto) measure(string phase, Fn&& fn) {
+    probe p{*this, move(phase)};
+    return fn();
+  }
+
+ private:
+  const clock::time_point m_origin;
+  std::atomic_bool m_enabled{false};
+  mutable std::mutex m_mutex;
+  vector<entry> m_entries;
+};
+
+POLYBAR_NS_END
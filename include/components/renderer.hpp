@@ -1,5 +1,7 @@
 #pragma once
 
+#include <mutex>
+
 #include "common.hpp"
 #include "components/types.hpp"
 #include "events/signal_fwd.hpp"
@@ -11,6 +13,7 @@
 POLYBAR_NS
 
 // fwd
+class action_index;
 class connection;
 class font_manager;
 class logger;
@@ -22,7 +25,7 @@ using std::map;
 class renderer
     : public signal_receiver<SIGN_PRIORITY_RENDERER, change_background, change_foreground, change_underline,
           change_overline, change_font, change_alignment, offset_pixel, attribute_set, attribute_unset,
-          attribute_toggle, action_begin, action_end, write_text_ascii, write_text_unicode, write_text_string> {
+          attribute_toggle, action_begin, action_end, write_text_string> {
  public:
   enum class gc : uint8_t { BG, FG, OL, UL, BT, BB, BL, BR };
 
@@ -30,7 +33,7 @@ class renderer
   static make_type make(const bar_settings& bar, vector<string>&& fonts);
 
   explicit renderer(connection& conn, signal_emitter& emitter, const logger& logger,
-      unique_ptr<font_manager> font_manager, const bar_settings& bar, const vector<string>& fonts);
+      shared_ptr<font_manager> font_manager, const bar_settings& bar, const vector<string>& fonts);
   ~renderer();
 
   renderer(const renderer& o) = delete;
@@ -54,16 +57,17 @@ class renderer
   void toggle_attribute(const attribute attr);
   bool check_attribute(const attribute attr);
 
+  xcb_gcontext_t fill_context(uint32_t color);
   void fill_background();
   void fill_overline(int16_t x, uint16_t w);
   void fill_underline(int16_t x, uint16_t w);
   void fill_shift(const int16_t px);
 
-  void draw_textstring(const uint16_t* text, size_t len);
+  void draw_textstring(const uint32_t* text, size_t len);
 
   void begin_action(const mousebtn btn, const string& cmd);
   void end_action(const mousebtn btn);
-  const vector<action_block> get_actions();
+  shared_ptr<const action_index> get_actions() const;
 
  protected:
   int16_t shift_content(int16_t x, const int16_t shift_x);
@@ -81,8 +85,6 @@ class renderer
   bool on(const attribute_toggle& evt);
   bool on(const action_begin& evt);
   bool on(const action_end& evt);
-  bool on(const write_text_ascii& evt);
-  bool on(const write_text_unicode& evt);
   bool on(const write_text_string& evt);
 
 #ifdef DEBUG_HINTS
@@ -100,7 +102,7 @@ class renderer
   connection& m_connection;
   signal_emitter& m_sig;
   const logger& m_log;
-  unique_ptr<font_manager> m_fontmanager;
+  shared_ptr<font_manager> m_fontmanager;
 
   const bar_settings& m_bar;
 
@@ -115,9 +117,43 @@ class renderer
   // xcb_gcontext_t m_gcontext;
   xcb_pixmap_t m_pixmap;
 
+  /**
+   * Last completed frame and its geometry, presented by flush().
+   * Frames are drawn into m_pixmap, which is swapped with the
+   * front buffer once the frame is complete
+   */
+  std::mutex m_flushlock;
+  xcb_pixmap_t m_frontbuffer;
+  xcb_rectangle_t m_frontrect{0, 0, 0U, 0U};
+  reserve_area m_frontarea{};
+
   map<gc, xcb_gcontext_t> m_gcontexts;
+
+  /**
+   * Contexts used to fill the background, underlines and overlines,
+   * keyed by color. The fill entries of m_gcontexts point into this pool
+   */
+  map<uint32_t, xcb_gcontext_t> m_fillcontexts;
+
+  /**
+   * Foreground of the FG context, which is only needed by core fonts
+   * and therefore only updated before drawing text with one
+   */
+  uint32_t m_gcforeground{0U};
   map<alignment, xcb_pixmap_t> m_pixmaps;
   vector<action_block> m_actions;
+  vector<size_t> m_openactions;
+
+  /**
+   * Total shift applied to the content of each alignment, the clickable
+   * areas are translated once the frame is complete instead of on every shift
+   */
+  map<alignment, double> m_actionshift;
+
+  /**
+   * Clickable areas of the last completed frame, read by the bar
+   */
+  shared_ptr<const action_index> m_actionindex;
 
   // bool m_autosize{false};
   uint16_t m_currentx{0U};
@@ -127,6 +163,12 @@ class renderer
   uint8_t m_fontindex{0};
 
   xcb_font_t m_gcfont{XCB_NONE};
+
+  /**
+   * Parser signals are only handled between begin() and end(), so
+   * that each bar's contents only end up in that bar's renderer
+   */
+  bool m_rendering{false};
 };
 
 POLYBAR_NS_END
@@ -3,6 +3,7 @@
 #include <atomic>
 #include <chrono>
 #include <condition_variable>
+#include <map>
 #include <mutex>
 #include <thread>
 
@@ -43,6 +44,7 @@ class taskqueue : non_copyable_mixin<taskqueue> {
       string id, deferred::duration ms, deferred::callback fn, deferred::duration offset = 0ms, size_t count = 1);
   void defer_unique(
       string id, deferred::duration ms, deferred::callback fn, deferred::duration offset = 0ms, size_t count = 1);
+  void throttle(string id, deferred::duration interval, deferred::callback fn);
 
   bool exist(const string& id);
   bool purge(const string& id);
@@ -57,6 +59,11 @@ class taskqueue : non_copyable_mixin<taskqueue> {
   std::atomic_bool m_active{true};
 
   vector<unique_ptr<deferred>> m_deferred;
+
+  /**
+   * Time of the most recent run scheduled by throttle(), per task id
+   */
+  std::map<string, deferred::timepoint> m_throttled;
 };
 
 POLYBAR_NS_END
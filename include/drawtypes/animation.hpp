@@ -1,6 +1,9 @@
 #pragma once
 
 #include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
 
 #include "common.hpp"
 #include "components/config.hpp"
@@ -14,30 +17,75 @@ namespace chrono = std::chrono;
 namespace drawtypes {
   class animation : public non_copyable_mixin<animation> {
    public:
+    using clock = chrono::steady_clock;
+
     explicit animation(int framerate_ms) : m_framerate_ms(framerate_ms) {}
     explicit animation(vector<icon_t>&& frames, int framerate_ms)
-        : m_frames(forward<decltype(frames)>(frames))
-        , m_framerate_ms(framerate_ms)
-        , m_framecount(m_frames.size())
-        , m_lastupdate(chrono::system_clock::now()) {}
+        : m_frames(forward<decltype(frames)>(frames)), m_framerate_ms(framerate_ms) {}
 
     void add(icon_t&& frame);
     icon_t get();
+    size_t frame_at(clock::time_point now) const;
     int framerate();
     operator bool();
 
    protected:
-    void tick();
-
     vector<icon_t> m_frames;
     int m_framerate_ms = 1000;
-    int m_frame = 0;
-    int m_framecount = 0;
-    chrono::system_clock::time_point m_lastupdate;
   };
 
   using animation_t = shared_ptr<animation>;
 
+  /**
+   * Single clock driving all animations of the bar
+   *
+   * Frames are derived from the time elapsed since a shared
+   * monotonic origin, so animations never drift and frames of
+   * animations with the same framerate change on the same tick.
+   * Subscribers are notified from the clock thread whenever the
+   * current frame of their animation changes
+   */
+  class animation_clock : public non_copyable_mixin<animation_clock> {
+   public:
+    using clock = animation::clock;
+    using callback = function<void()>;
+
+    using make_type = animation_clock&;
+    static make_type make();
+
+    explicit animation_clock();
+    ~animation_clock();
+
+    clock::time_point origin() const;
+
+    size_t subscribe(const animation_t& anim, callback&& fn);
+    void unsubscribe(size_t id);
+
+   protected:
+    void run();
+
+   private:
+    struct subscriber {
+      size_t id;
+      animation_t anim;
+      callback fn;
+      size_t frame;
+    };
+
+    const clock::time_point m_origin;
+
+    /**
+     * Held while subscribers are notified, which makes
+     * sure no callback is running once unsubscribe() returns
+     */
+    std::mutex m_lock;
+    std::condition_variable m_cond;
+    vector<subscriber> m_subscribers;
+    size_t m_nextid{1};
+    bool m_stop{false};
+    std::thread m_thread;
+  };
+
   animation_t load_animation(
       const config& conf, const string& section, string name = "animation", bool required = true);
 }
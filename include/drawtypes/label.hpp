@@ -76,6 +76,7 @@ namespace drawtypes {
 
   label_t load_label(const config& conf, const string& section, string name, bool required = true, string def = ""s);
   label_t load_optional_label(const config& conf, string section, string name, string def = ""s);
+  label_t make_label(const config& conf, const string& section, string name, string text);
 
   icon_t load_icon(const config& conf, string section, string name, bool required = true, string def = ""s);
   icon_t load_optional_icon(const config& conf, string section, string name, string def = ""s);
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <unordered_map>
+
 #include "common.hpp"
 #include "components/builder.hpp"
 #include "components/config.hpp"
@@ -28,10 +30,17 @@ namespace drawtypes {
     string output(float percentage);
 
    protected:
-    void fill(unsigned int perc, unsigned int fill_width);
+    string render(unsigned int fill_width, size_t color);
+    void fill(unsigned int fill_width, size_t color);
 
    private:
     unique_ptr<builder> m_builder;
+
+    /**
+     * Formatted output for each combination of fill width and color,
+     * which is all the output depends on
+     */
+    std::unordered_map<size_t, string> m_cache;
     vector<string> m_colors;
     string m_format;
     unsigned int m_width;
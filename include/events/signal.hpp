@@ -153,12 +153,6 @@ namespace signals {
     struct action_end : public detail::value_signal<action_end, mousebtn> {
       using base_type::base_type;
     };
-    struct write_text_ascii : public detail::value_signal<write_text_ascii, uint16_t> {
-      using base_type::base_type;
-    };
-    struct write_text_unicode : public detail::value_signal<write_text_unicode, uint16_t> {
-      using base_type::base_type;
-    };
     struct write_text_string : public detail::value_signal<write_text_string, polybar::parser::packet> {
       using base_type::base_type;
     };
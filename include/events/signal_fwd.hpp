@@ -51,8 +51,6 @@ namespace signals {
     struct attribute_toggle;
     struct action_begin;
     struct action_end;
-    struct write_text_ascii;
-    struct write_text_unicode;
     struct write_text_string;
   }
 }
@@ -57,7 +57,6 @@ namespace modules {
     state current_state();
     int current_percentage(state state);
     string current_time();
-    void subthread();
 
    private:
     static constexpr const char* FORMAT_CHARGING{"format-charging"};
@@ -98,7 +97,7 @@ namespace modules {
     size_t m_unchanged{SKIP_N_UNCHANGED};
     chrono::duration<double> m_interval{};
     chrono::system_clock::time_point m_lastpoll;
-    thread m_subthread;
+    size_t m_animation_subscription{0};
   };
 }
 
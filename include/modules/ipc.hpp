@@ -32,7 +32,7 @@ namespace modules {
     void update() {}
     string get_output();
     bool build(builder* builder, const string& tag) const;
-    void on_message(const string& message);
+    bool on_message(const string& message);
 
    private:
     static constexpr const char* TAG_OUTPUT{"<output>"};
@@ -7,6 +7,7 @@
 #include <mutex>
 
 #include "common.hpp"
+#include "components/metrics.hpp"
 #include "components/types.hpp"
 #include "errors.hpp"
 #include "utils/concurrency.hpp"
@@ -98,19 +99,28 @@ namespace modules {
 
   // }}}
 
+  /**
+   * Get a unique id for a new module instance
+   */
+  inline size_t make_module_id() {
+    static atomic<size_t> next{1};
+    return next++;
+  }
+
   // class definition : module_interface {{{
 
   struct module_interface {
    public:
     virtual ~module_interface() {}
 
+    virtual size_t id() const = 0;
     virtual string name() const = 0;
     virtual bool running() const = 0;
 
     virtual void start() = 0;
     virtual void stop() = 0;
     virtual void halt(string error_message) = 0;
-    virtual string contents() = 0;
+    virtual shared_ptr<const string> contents() = 0;
   };
 
   // }}}
@@ -119,15 +129,16 @@ namespace modules {
   template <class Impl>
   class module : public module_interface {
    public:
-    module(const bar_settings bar, string name);
+    module(const bar_settings& bar, string name);
     ~module() noexcept;
 
+    size_t id() const;
     string name() const;
     bool running() const;
     void stop();
     void halt(string error_message);
     void teardown();
-    string contents();
+    shared_ptr<const string> contents();
 
    protected:
     void broadcast();
@@ -148,16 +159,28 @@ namespace modules {
     mutex m_sleeplock;
     std::condition_variable m_sleephandler;
 
+    size_t m_id;
     string m_name;
     unique_ptr<builder> m_builder;
     unique_ptr<module_formatter> m_formatter;
     vector<thread> m_threads;
     thread m_mainthread;
 
+    /**
+     * Ids of the metrics recording the cost of update() and get_output()
+     */
+    size_t m_update_timer;
+    size_t m_output_timer;
+
    private:
     atomic<bool> m_enabled{true};
     atomic<bool> m_changed{true};
-    string m_cache;
+
+    /**
+     * Last output, replaced by a new buffer whenever the output changes.
+     * Consumers detect changes by comparing the buffers they were handed
+     */
+    shared_ptr<const string> m_cache;
   };
 
   // }}}
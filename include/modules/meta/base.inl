@@ -1,8 +1,10 @@
+#include "components/action_router.hpp"
 #include "components/builder.hpp"
 #include "components/config.hpp"
 #include "components/logger.hpp"
 #include "events/signal.hpp"
 #include "events/signal_emitter.hpp"
+#include "modules/meta/input_handler.hpp"
 
 POLYBAR_NS
 
@@ -10,14 +12,22 @@ namespace modules {
   // module<Impl> public {{{
 
   template <typename Impl>
-  module<Impl>::module(const bar_settings bar, string name)
+  module<Impl>::module(const bar_settings& bar, string name)
       : m_sig(signal_emitter::make())
       , m_bar(bar)
       , m_log(logger::make())
       , m_conf(config::make())
+      , m_id(make_module_id())
       , m_name("module/" + name)
-      , m_builder(make_unique<builder>(bar))
-      , m_formatter(make_unique<module_formatter>(m_conf, m_name)) {}
+      , m_builder(make_unique<builder>(m_bar))
+      , m_formatter(make_unique<module_formatter>(m_conf, m_name))
+      , m_update_timer(metrics::make().timer(m_name + ": update"))
+      , m_output_timer(metrics::make().timer(m_name + ": output")) {
+    // Address the actions of modules handling input to the module itself
+    if (std::is_base_of<input_handler, Impl>::value) {
+      m_builder->cmd_prefix(action_router::prefix(m_id));
+    }
+  }
 
   template <typename Impl>
   module<Impl>::~module() noexcept {
@@ -33,6 +43,11 @@ namespace modules {
     }
   }
 
+  template <typename Impl>
+  size_t module<Impl>::id() const {
+    return m_id;
+  }
+
   template <typename Impl>
   string module<Impl>::name() const {
     return m_name;
@@ -74,11 +89,16 @@ namespace modules {
   void module<Impl>::teardown() {}
 
   template <typename Impl>
-  string module<Impl>::contents() {
+  shared_ptr<const string> module<Impl>::contents() {
     if (m_changed) {
       m_log.info("%s: Rebuilding cache", name());
-      m_cache = CAST_MOD(Impl)->get_output();
+      metrics::probe probe{metrics::make(), m_output_timer};
+      string output{CAST_MOD(Impl)->get_output()};
       m_changed = false;
+
+      if (!m_cache || *m_cache != output) {
+        m_cache = make_shared<const string>(move(output));
+      }
     }
     return m_cache;
   }
@@ -33,7 +33,11 @@ namespace modules {
             continue;
           } else if (!this->running()) {
             break;
-          } else if (!CAST_MOD(Impl)->update()) {
+          }
+
+          metrics::probe probe{metrics::make(), this->m_update_timer};
+
+          if (!CAST_MOD(Impl)->update()) {
             continue;
           }
 
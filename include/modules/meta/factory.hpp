@@ -49,6 +49,27 @@ POLYBAR_NS
 using namespace modules;
 
 namespace {
+  /**
+   * Check if the module type can be constructed alongside other modules.
+   *
+   * Modules that lazily initialize process-wide X helpers (ewmh, xkb)
+   * during construction have to be created on the calling thread
+   */
+  bool make_module_concurrently(const string& name) {
+    return name != "internal/i3" && name != "internal/xkeyboard" && name != "internal/xwindow" &&
+           name != "internal/xworkspaces" && name != "internal/systray";
+  }
+
+  /**
+   * Check if the output of the module type depends on the monitor of the bar.
+   *
+   * Bars on different monitors that list the same module section get
+   * one instance of these modules each, other modules are shared
+   */
+  bool make_module_per_monitor(const string& name) {
+    return name == "internal/bspwm" || name == "internal/i3" || name == "internal/xbacklight";
+  }
+
   module_interface* make_module(string&& name, const bar_settings& bar, string module_name) {
     if (name == "internal/counter") {
       return new counter_module(bar, move(module_name));
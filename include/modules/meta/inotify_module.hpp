@@ -68,7 +68,13 @@ namespace modules {
               w->remove(true);
             }
 
-            if (CAST_MOD(Impl)->on_event(event.get())) {
+            bool changed;
+            {
+              metrics::probe probe{metrics::make(), this->m_update_timer};
+              changed = CAST_MOD(Impl)->on_event(event.get());
+            }
+
+            if (changed) {
               CAST_MOD(Impl)->broadcast();
             }
             CAST_MOD(Impl)->idle();
@@ -28,6 +28,7 @@ namespace modules {
           }
 
           std::unique_lock<std::mutex> guard(this->m_updatelock);
+          metrics::probe probe{metrics::make(), this->m_update_timer};
 
           if (CAST_MOD(Impl)->update()) {
             this->broadcast();
@@ -13,14 +13,12 @@ namespace modules {
    public:
     explicit network_module(const bar_settings&, string);
 
+    void start();
     void teardown();
     bool update();
     string get_format() const;
     bool build(builder* builder, const string& tag) const;
 
-   protected:
-    void subthread_routine();
-
    private:
     static constexpr auto FORMAT_CONNECTED = "format-connected";
     static constexpr auto FORMAT_PACKETLOSS = "format-packetloss";
@@ -38,6 +36,7 @@ namespace modules {
     ramp_t m_ramp_signal;
     ramp_t m_ramp_quality;
     animation_t m_animation_packetloss;
+    size_t m_animation_subscription{0};
     map<connection_state, label_t> m_label;
 
     atomic<bool> m_connected{false};
@@ -14,9 +14,12 @@ namespace modules {
 #define DEFINE_UNSUPPORTED_MODULE(MODULE_NAME, MODULE_TYPE)                             \
   class MODULE_NAME : public module_interface {                                         \
    public:                                                                              \
-    MODULE_NAME(const bar_settings, string) {                                           \
+    MODULE_NAME(const bar_settings&, string) {                                          \
       throw application_error("No built-in support for '" + string{MODULE_TYPE} + "'"); \
     }                                                                                   \
+    size_t id() const {                                                                 \
+      return 0;                                                                         \
+    }                                                                                   \
     string name() const {                                                               \
       return "";                                                                        \
     }                                                                                   \
@@ -26,8 +29,8 @@ namespace modules {
     void start() {}                                                                     \
     void stop() {}                                                                      \
     void halt(string) {}                                                                \
-    string contents() {                                                                 \
-      return "";                                                                        \
+    shared_ptr<const string> contents() {                                               \
+      return {};                                                                        \
     }                                                                                   \
   }
 
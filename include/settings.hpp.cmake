@@ -47,6 +47,7 @@
 
 static const size_t EVENT_SIZE = 64;
 
+static const int SIGN_PRIORITY_IPC{0};
 static const int SIGN_PRIORITY_CONTROLLER{1};
 static const int SIGN_PRIORITY_SCREEN{2};
 static const int SIGN_PRIORITY_BAR{3};
@@ -73,7 +74,7 @@ static constexpr const char* PATH_BACKLIGHT_VAL{"@SETTING_PATH_BACKLIGHT_VAL@"};
 static constexpr const char* PATH_BATTERY{"@SETTING_PATH_BATTERY@"};
 static constexpr const char* PATH_CPU_INFO{"@SETTING_PATH_CPU_INFO@"};
 static constexpr const char* PATH_MEMORY_INFO{"@SETTING_PATH_MEMORY_INFO@"};
-static constexpr const char* PATH_MESSAGING_FIFO{"@SETTING_PATH_MESSAGING_FIFO@"};
+static constexpr const char* PATH_MESSAGING_SOCKET{"@SETTING_PATH_MESSAGING_SOCKET@"};
 static constexpr const char* PATH_TEMPERATURE_INFO{"@SETTING_PATH_TEMPERATURE_INFO@"};
 
 static constexpr const char* BUILDER_SPACE_TOKEN{"%__"};
@@ -72,22 +72,88 @@ namespace color_util {
     return string{s, 0, len};
   }
 
-  inline string parse_hex(string hex) {
-    if (hex[0] != '#')
-      hex.insert(0, 1, '#');
-    if (hex.length() == 4)
-      hex = {'#', hex[1], hex[1], hex[2], hex[2], hex[3], hex[3]};
-    if (hex.length() == 7)
-      hex = "#ff" + hex.substr(1);
-    if (hex.length() != 9)
-      return "";
-    return hex;
+  /**
+   * Lookup table mapping characters to the value of the hex digit
+   * they represent, 0xff marks characters that are not hex digits
+   */
+  struct hex_table {
+    uint8_t values[256];
+
+    constexpr hex_table() : values{} {
+      for (size_t i = 0; i < 256; i++) {
+        values[i] = 0xff;
+      }
+      for (uint8_t i = 0; i < 10; i++) {
+        values['0' + i] = i;
+      }
+      for (uint8_t i = 0; i < 6; i++) {
+        values['a' + i] = values['A' + i] = 10 + i;
+      }
+    }
+  };
+
+  constexpr hex_table HEX_DIGITS{};
+
+  /**
+   * Decode a color in one of the forms #RGB, #ARGB, #RRGGBB or #AARRGGBB,
+   * the leading '#' is optional. Digits of the short forms are repeated
+   * and colors without alpha channel are opaque
+   *
+   * Returns false, leaving `color` untouched, if the input is invalid
+   */
+  constexpr bool decode(const char* hex, size_t len, uint32_t& color) {
+    if (len > 0 && hex[0] == '#') {
+      hex++;
+      len--;
+    }
+    if (len != 3 && len != 4 && len != 6 && len != 8) {
+      return false;
+    }
+
+    uint32_t value{0};
+    for (size_t i = 0; i < len; i++) {
+      uint8_t digit{HEX_DIGITS.values[static_cast<uint8_t>(hex[i])]};
+      if (digit == 0xff) {
+        return false;
+      }
+      value = value << 4 | digit;
+      if (len < 6) {
+        value = value << 4 | digit;
+      }
+    }
+
+    if (len == 3 || len == 6) {
+      value |= 0xff000000;
+    }
+
+    color = value;
+    return true;
+  }
+
+  template <size_t N>
+  constexpr uint32_t parse(const char (&hex)[N], uint32_t fallback = 0) {
+    uint32_t color{0};
+    return decode(hex, N - 1, color) ? color : fallback;
   }
 
-  inline uint32_t parse(string hex, uint32_t fallback = 0) {
-    if ((hex = parse_hex(hex)).empty())
-      return fallback;
-    return strtoul(&hex[1], nullptr, 16);
+  inline uint32_t parse(const string& hex, uint32_t fallback = 0) {
+    uint32_t color{0};
+    return decode(hex.data(), hex.size(), color) ? color : fallback;
+  }
+
+  /**
+   * Normalize a color to the #aarrggbb form, or return
+   * an empty string if it is invalid
+   */
+  inline string parse_hex(const string& hex) {
+    uint32_t color{0};
+    if (!decode(hex.data(), hex.size(), color)) {
+      return "";
+    }
+
+    char s[10];
+    snprintf(s, sizeof(s), "#%08x", color);
+    return string{s, 9};
   }
 
   inline string simplify_hex(string hex) {
@@ -1,7 +1,9 @@
 #pragma once
 
+#include <algorithm>
 #include <atomic>
 #include <chrono>
+#include <exception>
 #include <map>
 #include <mutex>
 #include <thread>
@@ -65,6 +67,52 @@ class mutex_wrapper : public T {
 
 namespace concurrency_util {
   size_t thread_id(const thread::id id);
+
+  /**
+   * Call fn(i) for each i in [0, count) using a bounded
+   * pool of worker threads. The calling thread takes part
+   * in the work and returns once every index has been processed.
+   *
+   * If fn throws, the remaining indexes are skipped and the
+   * first exception is rethrown on the calling thread
+   */
+  template <typename Fn>
+  void parallel_for(size_t count, const Fn& fn, size_t workers = 0) {
+    if (workers == 0) {
+      workers = std::max(1U, thread::hardware_concurrency());
+    }
+    workers = std::min(workers, count);
+
+    atomic<size_t> next{0};
+    std::exception_ptr error;
+    mutex error_lock;
+
+    auto worker = [&] {
+      for (size_t i; (i = next++) < count;) {
+        try {
+          fn(i);
+        } catch (...) {
+          std::lock_guard<mutex> guard(error_lock);
+          if (!error) {
+            error = std::current_exception();
+          }
+          next = count;
+        }
+      }
+    };
+
+    vector<thread> pool;
+    for (size_t i = 1; i < workers; i++) {
+      pool.emplace_back(worker);
+    }
+    worker();
+    for (auto&& t : pool) {
+      t.join();
+    }
+    if (error) {
+      std::rethrow_exception(error);
+    }
+  }
 }
 
 POLYBAR_NS_END
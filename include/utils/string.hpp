@@ -93,6 +93,8 @@ namespace string_util {
   string filesize(unsigned long long bytes, size_t precision = 0, bool fixed = false, const string& locale = "");
 
   hash_type hash(const string& src);
+
+  bool utf8_to_ucs4(const char* src, size_t len, vector<uint32_t>& result);
 }
 
 POLYBAR_NS_END
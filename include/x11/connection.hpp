@@ -119,6 +119,7 @@ class connection : public detail::connection_base<connection&, XPP_EXTENSION_LIS
   static make_type make(Display* display = nullptr);
 
   explicit connection(Display* dsp);
+  explicit connection(xcb_connection_t* conn);
   ~connection();
 
   const connection& operator=(const connection& o) {
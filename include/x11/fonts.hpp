@@ -10,9 +10,14 @@
 #include <unordered_map>
 
 #include "common.hpp"
+#include "settings.hpp"
 #include "x11/color.hpp"
 #include "x11/types.hpp"
 
+#if WITH_XRENDER
+#include <xcb/render.h>
+#endif
+
 POLYBAR_NS
 
 using std::map;
@@ -36,7 +41,12 @@ struct font_ref {
   uint16_t char_max{0};
   uint16_t char_min{0};
   vector<xcb_charinfo_t> width_lut{};
-  unordered_map<uint16_t, wchar_t> glyph_widths{};
+  unordered_map<uint32_t, wchar_t> glyph_widths{};
+#if WITH_XRENDER
+  // Server side copy of the glyphs, indexed by character. A glyph
+  // is uploaded once, when its width is first requested
+  xcb_render_glyphset_t glyphset{XCB_NONE};
+#endif
 
   static struct _deleter { void operator()(font_ref* font); } deleter;
 };
@@ -55,27 +65,36 @@ class font_manager {
   void set_visual(Visual* v);
 
   void cleanup();
+  void release(xcb_pixmap_t pm);
+  bool loaded() const;
   bool load(const string& name, uint8_t fontindex = 0, int8_t offset_y = 0);
   void fontindex(uint8_t index);
-  shared_ptr<font_ref> match_char(const uint16_t chr);
-  uint8_t glyph_width(const shared_ptr<font_ref>& font, const uint16_t chr);
+  shared_ptr<font_ref> match_char(const uint32_t chr);
+  uint8_t glyph_width(const shared_ptr<font_ref>& font, const uint32_t chr);
   void drawtext(const shared_ptr<font_ref>& font, xcb_pixmap_t pm, xcb_gcontext_t gc, int16_t x, int16_t y,
-      const uint16_t* chars, size_t num_chars);
+      const uint32_t* chars, size_t num_chars);
 
   void allocate_color(uint32_t color);
-  void allocate_color(XRenderColor color);
 
  protected:
   bool open_xcb_font(const shared_ptr<font_ref>& font, string fontname);
 
-  uint8_t glyph_width_xft(const shared_ptr<font_ref>& font, const uint16_t chr);
-  uint8_t glyph_width_xcb(const shared_ptr<font_ref>& font, const uint16_t chr);
+  uint8_t glyph_width_xft(const shared_ptr<font_ref>& font, const uint32_t chr);
+  uint8_t glyph_width_xcb(const shared_ptr<font_ref>& font, const uint32_t chr);
 
-  bool has_glyph_xft(const shared_ptr<font_ref>& font, const uint16_t chr);
-  bool has_glyph_xcb(const shared_ptr<font_ref>& font, const uint16_t chr);
+  bool has_glyph_xft(const shared_ptr<font_ref>& font, const uint32_t chr);
+  bool has_glyph_xcb(const shared_ptr<font_ref>& font, const uint32_t chr);
 
   void xcb_poly_text_16(xcb_drawable_t d, xcb_gcontext_t gc, int16_t x, int16_t y, uint8_t len, uint16_t* str);
 
+#if WITH_XRENDER
+  bool init_xrender();
+  uint8_t load_glyph(const shared_ptr<font_ref>& font, const uint32_t chr);
+  xcb_render_picture_t xrender_picture(xcb_pixmap_t pm);
+  void xrender_composite_glyphs(const shared_ptr<font_ref>& font, xcb_render_picture_t dst, int16_t x, int16_t y,
+      const uint32_t* chars, size_t num_chars);
+#endif
+
  private:
   connection& m_connection;
   const logger& m_logger;
@@ -89,7 +108,27 @@ class font_manager {
 
   XftDraw* m_xftdraw{nullptr};
   XftColor m_xftcolor{};
-  bool m_xftcolor_allocated{false};
+
+  /**
+   * Colors allocated so far, keyed by ARGB value. Switching
+   * to a known color only copies the pooled entry
+   */
+  map<uint32_t, XftColor> m_xftcolors;
+
+#if WITH_XRENDER
+  /**
+   * Xft fonts are drawn using XRender glyph sets on the xcb connection,
+   * Xft is then only used to open the fonts. The pen and the pictures
+   * wrapping the target pixmaps are kept alive between frames,
+   * with one pen per color in use
+   */
+  bool m_xrender{false};
+  xcb_render_pictformat_t m_format_a8{XCB_NONE};
+  xcb_render_pictformat_t m_format_visual{XCB_NONE};
+  xcb_render_picture_t m_pen{XCB_NONE};
+  map<uint32_t, xcb_render_picture_t> m_pens;
+  map<xcb_pixmap_t, xcb_render_picture_t> m_pictures;
+#endif
 };
 
 POLYBAR_NS_END
@@ -27,11 +27,14 @@ class tray_client {
   bool mapped() const;
   void mapped(bool state);
 
+  bool dirty() const;
+  void dirty(bool state);
+
   xcb_window_t window() const;
   xembed_data* xembed() const;
 
   void ensure_state() const;
-  void reconfigure(int16_t x, int16_t y) const;
+  void reconfigure(int16_t x, int16_t y);
   void configure_notify(int16_t x, int16_t y) const;
 
  protected:
@@ -40,6 +43,10 @@ class tray_client {
 
   shared_ptr<xembed_data> m_xembed;
   bool m_mapped{false};
+  bool m_dirty{true};
+
+  int16_t m_x{0};
+  int16_t m_y{0};
 
   uint16_t m_width;
   uint16_t m_height;
@@ -36,6 +36,7 @@ using namespace signals::ui;
 
 // fwd declarations
 class connection;
+class taskqueue;
 struct xembed_data;
 
 struct tray_settings {
@@ -70,7 +71,8 @@ class tray_manager : public xpp::event::sink<evt::expose, evt::visibility_notify
   using make_type = unique_ptr<tray_manager>;
   static make_type make();
 
-  explicit tray_manager(connection& conn, signal_emitter& emitter, const logger& logger);
+  explicit tray_manager(
+      connection& conn, signal_emitter& emitter, const logger& logger, unique_ptr<taskqueue>&& taskqueue);
 
   ~tray_manager();
 
@@ -86,7 +88,8 @@ class tray_manager : public xpp::event::sink<evt::expose, evt::visibility_notify
   void reconfigure_window();
   void reconfigure_clients();
   void reconfigure_bg(bool realloc = false);
-  void refresh_window();
+  void refresh_window(bool clear_clients = false);
+  void refresh_window_unlocked(bool clear_clients = false);
   void redraw_window(bool realloc_bg = false);
 
   void query_atom();
@@ -155,12 +158,11 @@ class tray_manager : public xpp::event::sink<evt::expose, evt::visibility_notify
   atomic<bool> m_hidden{false};
   atomic<bool> m_acquired_selection{false};
 
-  thread m_delaythread;
+  unique_ptr<taskqueue> m_taskqueue;
+  atomic<bool> m_realloc_bg{false};
 
   mutex m_mtx{};
 
-  chrono::time_point<chrono::system_clock, chrono::milliseconds> m_drawtime;
-
   bool m_firstactivation{true};
 };
 
@@ -0,0 +1,91 @@
+#include <algorithm>
+#include <set>
+
+#include "components/action_index.hpp"
+
+POLYBAR_NS
+
+/**
+ * Build the index from the action blocks of a rendered frame
+ *
+ * Blocks that were never closed are not clickable and get left out
+ */
+action_index::action_index(vector<action_block>&& blocks) : m_actions(forward<decltype(blocks)>(blocks)) {
+  struct boundary {
+    int32_t x;
+    size_t action;
+    bool open;
+  };
+
+  std::array<vector<boundary>, BUTTONS> boundaries;
+
+  // A block covers the positions start_x < x <= end_x (see action_block::test)
+  for (size_t i = 0; i < m_actions.size(); i++) {
+    const auto& action = m_actions[i];
+    auto button = static_cast<size_t>(action.button);
+    int32_t from{static_cast<int16_t>(action.start_x) + 1};
+    int32_t to{static_cast<int16_t>(action.end_x) + 1};
+
+    if (!action.active && button < BUTTONS && from < to) {
+      boundaries[button].emplace_back(boundary{from, i, true});
+      boundaries[button].emplace_back(boundary{to, i, false});
+    }
+  }
+
+  for (size_t button = 0; button < BUTTONS; button++) {
+    auto& points = boundaries[button];
+    auto& segments = m_segments[button];
+    std::set<size_t> covering;
+
+    std::sort(points.begin(), points.end(), [](const boundary& a, const boundary& b) { return a.x < b.x; });
+
+    for (size_t i = 0; i < points.size();) {
+      int32_t x{points[i].x};
+
+      for (; i < points.size() && points[i].x == x; i++) {
+        if (points[i].open) {
+          covering.emplace(points[i].action);
+        } else {
+          covering.erase(points[i].action);
+        }
+      }
+
+      // The block opened first wins where blocks overlap
+      size_t action{covering.empty() ? NONE : *covering.begin()};
+
+      if (segments.empty() ? action != NONE : segments.back().action != action) {
+        segments.emplace_back(segment{x, action});
+      }
+    }
+  }
+}
+
+/**
+ * Find the block hit by a click with given button at given position
+ *
+ * Returns nullptr if no block covers the position
+ */
+const action_block* action_index::find(mousebtn button, int16_t x) const {
+  if (static_cast<size_t>(button) >= BUTTONS) {
+    return nullptr;
+  }
+
+  const auto& segments = m_segments[static_cast<size_t>(button)];
+  auto it = std::upper_bound(
+      segments.begin(), segments.end(), x, [](int32_t x, const segment& s) { return x < s.x; });
+
+  if (it == segments.begin() || (--it)->action == NONE) {
+    return nullptr;
+  }
+
+  return &m_actions[it->action];
+}
+
+/**
+ * Check if any clickable block uses given button
+ */
+bool action_index::has(mousebtn button) const {
+  return static_cast<size_t>(button) < BUTTONS && !m_segments[static_cast<size_t>(button)].empty();
+}
+
+POLYBAR_NS_END
@@ -0,0 +1,90 @@
+#include "components/action_router.hpp"
+#include "modules/meta/input_handler.hpp"
+
+POLYBAR_NS
+
+/**
+ * Get the prefix for actions created by the module with given id
+ */
+string action_router::prefix(size_t id) {
+  return "#" + to_string(id) + ".";
+}
+
+/**
+ * Remove the module prefix from given action
+ */
+string action_router::strip(const string& action) {
+  string command{action};
+  size_t id;
+  split(command, id);
+  return command;
+}
+
+/**
+ * Register input handler
+ */
+void action_router::add(size_t id, modules::input_handler* handler) {
+  m_routes[id] = handler;
+  m_handlers.emplace_back(handler);
+}
+
+/**
+ * Remove all registered handlers
+ */
+void action_router::clear() {
+  m_routes.clear();
+  m_handlers.clear();
+}
+
+/**
+ * Pass action to the handler that accepts it
+ *
+ * The module prefix is removed from the action, so that it
+ * can be used as is if no handler accepted it
+ */
+bool action_router::dispatch(string& action) const {
+  modules::input_handler* owner{nullptr};
+  size_t id;
+
+  if (split(action, id)) {
+    auto it = m_routes.find(id);
+    if (it != m_routes.end() && (owner = it->second)->input(string{action})) {
+      return true;
+    }
+  }
+
+  for (auto&& handler : m_handlers) {
+    if (handler != owner && handler->input(string{action})) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+/**
+ * Split the module prefix from given action
+ *
+ * Returns false if the action has no module prefix
+ */
+bool action_router::split(string& action, size_t& id) {
+  if (action.empty() || action[0] != '#') {
+    return false;
+  }
+
+  size_t pos{1};
+  id = 0;
+
+  while (pos < action.size() && action[pos] >= '0' && action[pos] <= '9') {
+    id = id * 10 + (action[pos++] - '0');
+  }
+
+  if (pos == 1 || pos == action.size() || action[pos] != '.') {
+    return false;
+  }
+
+  action.erase(0, pos + 1);
+  return true;
+}
+
+POLYBAR_NS_END
@@ -1,8 +1,11 @@
 #include <xcb/xcb_icccm.h>
 #include <algorithm>
+#include <cmath>
 
 #include "components/bar.hpp"
+#include "components/action_index.hpp"
 #include "components/config.hpp"
+#include "components/metrics.hpp"
 #include "components/parser.hpp"
 #include "components/renderer.hpp"
 #include "components/screen.hpp"
@@ -32,18 +35,29 @@ using namespace wm_util;
 
 /**
  * Create instance
+ *
+ * The tray is only created for the primary bar, i.e.
+ * the bar the configuration was loaded for
  */
-bar::make_type bar::make(bool only_initialize_values) {
+bar::make_type bar::make(string name, bool only_initialize_values) {
+  const config& conf{config::make()};
+  unique_ptr<tray_manager> tray{};
+
+  if ("bar/" + name == conf.section()) {
+    tray = tray_manager::make();
+  }
+
   // clang-format off
   return factory_util::unique<bar>(
         connection::make(),
         signal_emitter::make(),
-        config::make(),
+        conf,
         logger::make(),
         screen::make(),
-        tray_manager::make(),
+        move(tray),
         parser::make(),
         taskqueue::make(),
+        move(name),
         only_initialize_values);
   // clang-format on
 }
@@ -55,7 +69,7 @@ bar::make_type bar::make(bool only_initialize_values) {
  */
 bar::bar(connection& conn, signal_emitter& emitter, const config& config, const logger& logger,
     unique_ptr<screen>&& screen, unique_ptr<tray_manager>&& tray_manager, unique_ptr<parser>&& parser,
-    unique_ptr<taskqueue>&& taskqueue, bool only_initialize_values)
+    unique_ptr<taskqueue>&& taskqueue, string&& name, bool only_initialize_values)
     : m_connection(conn)
     , m_sig(emitter)
     , m_conf(config)
@@ -63,8 +77,13 @@ bar::bar(connection& conn, signal_emitter& emitter, const config& config, const
     , m_screen(forward<decltype(screen)>(screen))
     , m_tray(forward<decltype(tray_manager)>(tray_manager))
     , m_parser(forward<decltype(parser)>(parser))
-    , m_taskqueue(forward<decltype(taskqueue)>(taskqueue)) {
-  string bs{m_conf.section()};
+    , m_taskqueue(forward<decltype(taskqueue)>(taskqueue))
+    , m_section("bar/" + name) {
+  string bs{m_section};
+
+  if (!m_conf.has_section(bs)) {
+    throw application_error("Undefined bar: " + name);
+  }
 
   // Get available RandR outputs
   auto monitor_name = m_conf.get(bs, "monitor", ""s);
@@ -156,7 +175,7 @@ bar::bar(connection& conn, signal_emitter& emitter, const config& config, const
   }
 
   if (only_initialize_values) {
-    return;
+    return publish_settings();
   }
 
   // Load values used to adjust the struts atom
@@ -211,10 +230,10 @@ bar::bar(connection& conn, signal_emitter& emitter, const config& config, const
   m_opts.borders[edge::RIGHT].color = color::parse(m_conf.get(bs, "border-right-color", border_color));
 
   // Load geometry values
-  auto w = m_conf.get(m_conf.section(), "width", "100%"s);
-  auto h = m_conf.get(m_conf.section(), "height", "24"s);
-  auto offsetx = m_conf.get(m_conf.section(), "offset-x", ""s);
-  auto offsety = m_conf.get(m_conf.section(), "offset-y", ""s);
+  auto w = m_conf.get(bs, "width", "100%"s);
+  auto h = m_conf.get(bs, "height", "24"s);
+  auto offsetx = m_conf.get(bs, "offset-x", ""s);
+  auto offsety = m_conf.get(bs, "offset-y", ""s);
 
   if ((m_opts.size.w = atoi(w.c_str())) && w.find('%') != string::npos) {
     m_opts.size.w = math_util::percentage_to_value<int>(m_opts.size.w, m_opts.monitor->w);
@@ -259,7 +278,7 @@ bar::bar(connection& conn, signal_emitter& emitter, const config& config, const
   m_opts.center.x += m_opts.borders[edge::LEFT].size;
 
   m_log.trace("bar: Create renderer");
-  auto fonts = m_conf.get_list(m_conf.section(), "font", {});
+  auto fonts = m_conf.get_list(bs, "font", {});
   m_renderer = renderer::make(m_opts, move(fonts));
 
   m_log.trace("bar: Attaching sink to registry");
@@ -267,6 +286,7 @@ bar::bar(connection& conn, signal_emitter& emitter, const config& config, const
 
   m_log.info("Bar geometry: %ix%i+%i+%i", m_opts.size.w, m_opts.size.h, m_opts.pos.x, m_opts.pos.y);
   m_opts.window = m_renderer->window();
+  publish_settings();
 
   // Subscribe to window enter and leave events
   // if we should dim the window
@@ -288,6 +308,9 @@ bar::bar(connection& conn, signal_emitter& emitter, const config& config, const
   // Required by Openbox
   reconfigure_pos();
 
+  m_anim.y = m_opts.pos.y;
+  m_anim.h = m_opts.size.h;
+
   m_log.trace("bar: Drawing empty bar");
   m_renderer->begin();
   m_renderer->fill_background();
@@ -306,33 +329,75 @@ bar::~bar() {
 }
 
 /**
- * Get the bar settings container
+ * Get the name of the config section that defines the bar
  */
-const bar_settings bar::settings() const {
-  return m_opts;
+string bar::section() const {
+  return m_section;
 }
 
 /**
- * Parse input string and redraw the bar window
+ * Get the current bar settings
+ *
+ * The returned snapshot is never modified, changes to
+ * the settings are published as a new snapshot
+ */
+shared_ptr<const bar_settings> bar::settings() const {
+  return std::atomic_load(&m_settings);
+}
+
+/**
+ * Queue input string to be parsed and drawn onto the bar window
+ *
+ * Only the latest input is kept, it is drawn by the next call to draw().
+ * Inputs are never modified, a new buffer is passed for changed data
  *
  * @param data Input string
  * @param force Unless true, do not parse unchanged data
  */
-void bar::parse(string&& data, bool force) {
-  if (!m_mutex.try_lock()) {
+void bar::parse(shared_ptr<const string> data, bool force) {
+  std::lock_guard<std::mutex> guard(m_pendinglock);
+  m_pending = move(data);
+  m_pendingforce = m_pendingforce || force;
+  m_haspending = true;
+}
+
+/**
+ * Draw the latest queued input, if any
+ *
+ * Unforced input is held back while the bar is shaded, since
+ * unchanged contents are not passed to the bar again
+ *
+ * Called by the render thread of the controller
+ */
+void bar::draw() {
+  std::unique_lock<std::mutex> guard(m_pendinglock);
+  if (!m_haspending) {
     return;
+  } else if (!m_pendingforce && settings()->shaded) {
+    return m_log.trace("bar: Holding back update (shaded)");
   }
+  auto input = move(m_pending);
+  bool force{m_pendingforce};
+  m_pendingforce = false;
+  m_haspending = false;
+  guard.unlock();
 
-  std::lock_guard<std::mutex> guard(m_mutex, std::adopt_lock);
+  render(input, force);
+}
 
+/**
+ * Parse input string and redraw the bar window
+ */
+void bar::render(const shared_ptr<const string>& data, bool force) {
   if (force) {
     m_log.trace("bar: Force update");
-  } else if (m_opts.shaded) {
-    return m_log.trace("bar: Ignoring update (shaded)");
   } else if (data == m_lastinput) {
     return;
   }
 
+  static const size_t timer{metrics::make().timer("bar: parse")};
+  metrics::probe probe{metrics::make(), timer};
+
   m_lastinput = data;
 
   m_log.info("Redrawing bar window");
@@ -349,7 +414,7 @@ void bar::parse(string&& data, bool force) {
   m_renderer->fill_background();
 
   try {
-    m_parser->parse(settings(), data);
+    m_parser->parse(*settings(), *data);
   } catch (const parser_error& err) {
     m_log.err("Failed to parse contents (reason: %s)", err.what());
   }
@@ -357,10 +422,10 @@ void bar::parse(string&& data, bool force) {
   m_renderer->end();
 
   const auto check_dblclicks = [&]() -> bool {
-    for (auto&& action : m_renderer->get_actions()) {
-      if (static_cast<uint8_t>(action.button) >= static_cast<uint8_t>(mousebtn::DOUBLE_LEFT)) {
-        return true;
-      }
+    auto actions = m_renderer->get_actions();
+    if (actions->has(mousebtn::DOUBLE_LEFT) || actions->has(mousebtn::DOUBLE_MIDDLE) ||
+        actions->has(mousebtn::DOUBLE_RIGHT)) {
+      return true;
     }
     for (auto&& action : m_opts.actions) {
       if (static_cast<uint8_t>(action.button) >= static_cast<uint8_t>(mousebtn::DOUBLE_LEFT)) {
@@ -372,6 +437,13 @@ void bar::parse(string&& data, bool force) {
   m_dblclicks = check_dblclicks();
 }
 
+/**
+ * Publish a snapshot of the current settings
+ */
+void bar::publish_settings() {
+  std::atomic_store(&m_settings, shared_ptr<const bar_settings>{make_shared<bar_settings>(m_opts)});
+}
+
 /**
  * Move the bar window above defined sibling
  * in the X window stack
@@ -380,7 +452,7 @@ void bar::restack_window() {
   string wm_restack;
 
   try {
-    wm_restack = m_conf.get(m_conf.section(), "wm-restack");
+    wm_restack = m_conf.get(m_section, "wm-restack");
   } catch (const key_error& err) {
     return;
   }
@@ -463,8 +535,15 @@ void bar::reconfigure_wm_hints() {
 
 /**
  * Broadcast current map state
+ *
+ * Only the primary bar reports its state, since the
+ * tray is attached to it
  */
 void bar::broadcast_visibility() {
+  if (!m_tray) {
+    return;
+  }
+
   auto attr = m_connection.get_window_attributes(m_opts.window);
 
   if (attr->map_state == XCB_MAP_STATE_UNVIEWABLE) {
@@ -501,19 +580,20 @@ void bar::handle(const evt::destroy_notify& evt) {
  * Used to brighten the window by setting the
  * _NET_WM_WINDOW_OPACITY atom value
  */
-void bar::handle(const evt::enter_notify&) {
+void bar::handle(const evt::enter_notify& evt) {
+  if (evt->event != m_opts.window) {
+    return;
+  }
+
 #if DEBUG
   if (m_opts.origin == edge::TOP) {
-    m_taskqueue->defer_unique("window-hover", 25ms, [&](size_t) { m_sig.emit(signals::ui::unshade_window{}); });
+    m_taskqueue->defer_unique("window-hover", 25ms, [&](size_t) { unshade(); });
     return;
   }
 #endif
 
   if (m_opts.dimmed) {
-    m_taskqueue->defer_unique("window-dim", 25ms, [&](size_t) {
-      m_opts.dimmed = false;
-      m_sig.emit(dim_window{1.0});
-    });
+    m_taskqueue->defer_unique("window-dim", 25ms, [&](size_t) { dim(1.0); });
   } else if (m_taskqueue->exist("window-dim")) {
     m_taskqueue->purge("window-dim");
   }
@@ -525,19 +605,20 @@ void bar::handle(const evt::enter_notify&) {
  * Used to dim the window by setting the
  * _NET_WM_WINDOW_OPACITY atom value
  */
-void bar::handle(const evt::leave_notify&) {
+void bar::handle(const evt::leave_notify& evt) {
+  if (evt->event != m_opts.window) {
+    return;
+  }
+
 #if DEBUG
   if (m_opts.origin == edge::TOP) {
-    m_taskqueue->defer_unique("window-hover", 25ms, [&](size_t) { m_sig.emit(signals::ui::shade_window{}); });
+    m_taskqueue->defer_unique("window-hover", 25ms, [&](size_t) { shade(); });
     return;
   }
 #endif
 
   if (!m_opts.dimmed) {
-    m_taskqueue->defer_unique("window-dim", 3s, [&](size_t) {
-      m_opts.dimmed = true;
-      m_sig.emit(dim_window{double(m_opts.dimvalue)});
-    });
+    m_taskqueue->defer_unique("window-dim", 3s, [&](size_t) { dim(m_opts.dimvalue); });
   }
 }
 
@@ -547,7 +628,7 @@ void bar::handle(const evt::leave_notify&) {
  * Used to map mouse clicks to bar actions
  */
 void bar::handle(const evt::button_press& evt) {
-  if (!m_mutex.try_lock()) {
+  if (evt->event != m_opts.window || !m_mutex.try_lock()) {
     return;
   }
 
@@ -563,12 +644,11 @@ void bar::handle(const evt::button_press& evt) {
   m_buttonpress_pos = evt->event_x;
 
   const auto deferred_fn = [&](size_t) {
-    for (auto&& action : m_renderer->get_actions()) {
-      if (action.button == m_buttonpress_btn && !action.active && action.test(m_buttonpress_pos)) {
-        m_log.trace("Found matching input area");
-        m_sig.emit(button_press{string{action.command}});
-        return;
-      }
+    auto actions = m_renderer->get_actions();
+    if (auto action = actions->find(m_buttonpress_btn, m_buttonpress_pos)) {
+      m_log.trace("Found matching input area");
+      m_sig.emit(button_press{string{action->command}});
+      return;
     }
     for (auto&& action : m_opts.actions) {
       if (action.button == m_buttonpress_btn && !action.command.empty()) {
@@ -613,7 +693,7 @@ void bar::handle(const evt::button_press& evt) {
  */
 void bar::handle(const evt::expose& evt) {
   if (evt->window == m_opts.window && evt->count == 0) {
-    if (m_tray->settings().running) {
+    if (m_tray && m_tray->settings().running) {
       broadcast_visibility();
     }
 
@@ -646,42 +726,48 @@ void bar::handle(const evt::property_notify& evt) {
 }
 
 bool bar::on(const signals::eventqueue::start&) {
-  m_log.trace("bar: Setup tray manager");
-  m_tray->setup(static_cast<const bar_settings&>(m_opts));
-  broadcast_visibility();
-  return true;
+  if (m_tray) {
+    m_log.trace("bar: Setup tray manager");
+    m_tray->setup(static_cast<const bar_settings&>(m_opts));
+    broadcast_visibility();
+  }
+  return false;
 }
 
-bool bar::on(const signals::ui::unshade_window&) {
+/**
+ * Expand the window back to its full size
+ */
+void bar::unshade() {
   m_opts.shaded = false;
   m_opts.shade_size.w = m_opts.size.w;
   m_opts.shade_size.h = m_opts.size.h;
   m_opts.shade_pos.x = m_opts.pos.x;
   m_opts.shade_pos.y = m_opts.pos.y;
+  publish_settings();
 
-  double distance{static_cast<double>(m_opts.shade_size.h - m_connection.get_geometry(m_opts.window)->height)};
-  double steptime{25.0 / 10.0};
-  m_anim_step = distance / steptime / 2.0;
+  animate(25ms);
 
   m_taskqueue->defer_unique("window-shade", 25ms,
       [&](size_t remaining) {
         if (!m_opts.shaded) {
-          m_sig.emit(signals::ui::tick{});
+          tick();
         }
         if (!remaining) {
           m_renderer->flush(false);
         }
         if (m_opts.dimmed) {
-          m_opts.dimmed = false;
-          m_sig.emit(dim_window{1.0});
+          dim(1.0);
         }
       },
       taskqueue::deferred::duration{25ms}, 10U);
 
-  return true;
+  m_sig.emit(signals::ui::unshade_window{});
 }
 
-bool bar::on(const signals::ui::shade_window&) {
+/**
+ * Collapse the window to a thin strip
+ */
+void bar::shade() {
   taskqueue::deferred::duration offset{2000ms};
 
   if (!m_opts.shaded && m_opts.shade_size.h != m_opts.size.h) {
@@ -698,52 +784,66 @@ bool bar::on(const signals::ui::shade_window&) {
     m_opts.shade_pos.y = m_opts.pos.y + m_opts.size.h - m_opts.shade_size.h;
   }
 
-  double distance{static_cast<double>(m_connection.get_geometry(m_opts.window)->height - m_opts.shade_size.h)};
-  double steptime{25.0 / 10.0};
-  m_anim_step = distance / steptime / 2.0;
+  publish_settings();
+
+  animate(offset);
 
   m_taskqueue->defer_unique("window-shade", 25ms,
       [&](size_t remaining) {
         if (m_opts.shaded) {
-          m_sig.emit(signals::ui::tick{});
+          tick();
         }
         if (!remaining) {
           m_renderer->flush(false);
         }
         if (!m_opts.dimmed) {
-          m_opts.dimmed = true;
-          m_sig.emit(dim_window{double{m_opts.dimvalue}});
+          dim(m_opts.dimvalue);
         }
       },
       move(offset), 10U);
 
-  return true;
+  m_sig.emit(signals::ui::shade_window{});
 }
 
-bool bar::on(const signals::ui::tick&) {
-  auto geom = m_connection.get_geometry(m_opts.window);
-  if (geom->y == m_opts.shade_pos.y && geom->height == m_opts.shade_size.h) {
-    return false;
+/**
+ * Start animating the window from its current geometry
+ * towards the shade geometry after given delay
+ */
+void bar::animate(std::chrono::milliseconds delay) {
+  m_anim.start = std::chrono::steady_clock::now() + delay;
+  m_anim.from_y = m_anim.y;
+  m_anim.from_h = m_anim.h;
+}
+
+/**
+ * Move the window to the position of the shade animation at this time
+ *
+ * The position follows an ease-out curve over the elapsed time, so that
+ * late or dropped steps do not slow down the animation. The geometry is
+ * tracked locally, the window is only reconfigured when it changes
+ */
+void bar::tick() {
+  std::chrono::duration<double> elapsed{std::chrono::steady_clock::now() - m_anim.start};
+  double progress{math_util::cap(elapsed / m_anim.duration, 0.0, 1.0)};
+  double eased{1.0 - std::pow(1.0 - progress, 3.0)};
+
+  auto y = static_cast<int16_t>(std::lround(m_anim.from_y + (m_opts.shade_pos.y - m_anim.from_y) * eased));
+  auto h = static_cast<uint16_t>(std::lround(m_anim.from_h + (m_opts.shade_size.h - m_anim.from_h) * eased));
+  h = std::max<uint16_t>(1U, h);
+
+  if (y == m_anim.y && h == m_anim.h) {
+    return;
   }
 
   uint32_t mask{0};
   uint32_t values[7]{0};
   xcb_params_configure_window_t params{};
 
-  if (m_opts.shade_size.h > geom->height) {
-    XCB_AUX_ADD_PARAM(&mask, &params, height, static_cast<uint16_t>(geom->height + m_anim_step));
-    params.height = std::max(1U, std::min(params.height, static_cast<uint32_t>(m_opts.shade_size.h)));
-  } else if (m_opts.shade_size.h < geom->height) {
-    XCB_AUX_ADD_PARAM(&mask, &params, height, static_cast<uint16_t>(geom->height - m_anim_step));
-    params.height = std::max(1U, std::max(params.height, static_cast<uint32_t>(m_opts.shade_size.h)));
+  if (h != m_anim.h) {
+    XCB_AUX_ADD_PARAM(&mask, &params, height, h);
   }
-
-  if (m_opts.shade_pos.y > geom->y) {
-    XCB_AUX_ADD_PARAM(&mask, &params, y, static_cast<int16_t>(geom->y + m_anim_step));
-    params.y = std::min(params.y, static_cast<int32_t>(m_opts.shade_pos.y));
-  } else if (m_opts.shade_pos.y < geom->y) {
-    XCB_AUX_ADD_PARAM(&mask, &params, y, static_cast<int16_t>(geom->y - m_anim_step));
-    params.y = std::max(params.y, static_cast<int32_t>(m_opts.shade_pos.y));
+  if (y != m_anim.y) {
+    XCB_AUX_ADD_PARAM(&mask, &params, y, y);
   }
 
   connection::pack_values(mask, &params, values);
@@ -751,14 +851,26 @@ bool bar::on(const signals::ui::tick&) {
   m_connection.configure_window(m_opts.window, mask, values);
   m_connection.flush();
 
-  return false;
+  m_anim.y = y;
+  m_anim.h = h;
 }
 
-bool bar::on(const signals::ui::dim_window& sig) {
-  m_opts.dimmed = sig.cast() != 1.0;
-  set_wm_window_opacity(m_connection, m_opts.window, sig.cast() * 0xFFFFFFFF);
+/**
+ * Set the window opacity
+ *
+ * The tray follows the opacity of the primary bar
+ */
+void bar::dim(double opacity) {
+  if (m_opts.dimmed != (opacity != 1.0)) {
+    m_opts.dimmed = opacity != 1.0;
+    publish_settings();
+  }
+  set_wm_window_opacity(m_connection, m_opts.window, opacity * 0xFFFFFFFF);
   m_connection.flush();
-  return false;
+
+  if (m_tray) {
+    m_sig.emit(dim_window{double{opacity}});
+  }
 }
 
 POLYBAR_NS_END
@@ -506,12 +506,19 @@ void builder::underline_close() {
   tag_close(attribute::UNDERLINE);
 }
 
+/**
+ * Set prefix added to the command of all command tags
+ */
+void builder::cmd_prefix(string prefix) {
+  m_cmdprefix = move(prefix);
+}
+
 /**
  * Open command tag
  */
 void builder::cmd(mousebtn index, string action, bool condition) {
   if (condition && !action.empty()) {
-    action = string_util::replace_all(action, ":", "\\:");
+    action = m_cmdprefix + string_util::replace_all(action, ":", "\\:");
     tag_open(syntaxtag::A, to_string(static_cast<int>(index)) + ":" + action + ":");
   }
 }
@@ -521,7 +528,7 @@ void builder::cmd(mousebtn index, string action, bool condition) {
  */
 void builder::cmd(mousebtn index, string action, const label_t& label) {
   if (!action.empty() && label && *label) {
-    action = string_util::replace_all(action, ":", "\\:");
+    action = m_cmdprefix + string_util::replace_all(action, ":", "\\:");
     tag_open(syntaxtag::A, to_string(static_cast<int>(index)) + ":" + action + ":");
     node(label);
     tag_close(syntaxtag::A);
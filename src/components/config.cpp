@@ -1,5 +1,8 @@
+#include <algorithm>
 #include <climits>
+#include <cstring>
 #include <fstream>
+#include <map>
 
 #include "components/config.hpp"
 #include "utils/env.hpp"
@@ -33,16 +36,10 @@ config::config(const logger& logger, const xresource_manager& xrm, string&& path
 
   parse_file();
   copy_inherited();
+  resolve_all();
+  index_lists();
 
-  bool found_bar{false};
-  for (auto&& p : m_sections) {
-    if (p.first == section()) {
-      found_bar = true;
-      break;
-    }
-  }
-
-  if (!found_bar) {
+  if (m_sections.find(section()) == m_sections.end()) {
     throw application_error("Undefined bar: " + m_barname);
   }
 
@@ -68,27 +65,171 @@ string config::section() const {
  * Print a deprecation warning if the given parameter is set
  */
 void config::warn_deprecated(const string& section, const string& key, string replacement) const {
-  try {
-    auto value = get<string>(section, key);
+  if (has(section, key)) {
     m_log.warn(
         "The config parameter `%s.%s` is deprecated, use `%s.%s` instead.", section, key, section, move(replacement));
-  } catch (const key_error& err) {
   }
 }
 
+/**
+ * Set parameter value
+ *
+ * Only the parameter and the parameters referring to it,
+ * directly or through other references, are resolved again
+ */
+void config::set(const string& section, const string& key, string&& value) {
+  std::unique_lock<std::shared_timed_mutex> guard(m_lock);
+  auto& values = m_sections[section];
+  auto it = values.find(key);
+  bool added{it == values.end()};
+
+  if (added) {
+    it = values.emplace(key, entry{forward<string>(value)}).first;
+  } else {
+    it->second.raw = forward<string>(value);
+  }
+
+  struct stale_entry {
+    const string& section;
+    const string& key;
+    entry& e;
+  };
+
+  vector<stale_entry> stale{{section, it->first, it->second}};
+
+  for (size_t n = 0; n < stale.size(); n++) {
+    for (auto&& s : m_sections) {
+      for (auto&& param : s.second) {
+        if (referenced(s.first, param.second.raw) != &stale[n].e) {
+          continue;
+        } else if (std::find_if(stale.begin(), stale.end(), [&](const stale_entry& st) {
+                     return &st.e == &param.second;
+                   }) == stale.end()) {
+          stale.emplace_back(stale_entry{s.first, param.first, param.second});
+        }
+      }
+    }
+  }
+
+  std::lock_guard<std::mutex> cache_guard(m_cachelock);
+
+  for (auto&& st : stale) {
+    st.e.status = entry::state::UNRESOLVED;
+    st.e.error.clear();
+    st.e.cache.clear();
+  }
+
+  for (auto&& st : stale) {
+    try {
+      resolve(st.section, st.key, st.e);
+    } catch (const value_error& err) {
+      m_log.trace("config: %s", err.what());
+    }
+  }
+
+  // Existing entries keep their address, only new keys can start or extend a list
+  if (added) {
+    index_lists(section);
+  }
+}
+
+/**
+ * Parse the file again and replace the current values
+ *
+ * Returns the parameters that were added, removed or got
+ * a different value, grouped by section. If the file can't
+ * be loaded the current values are kept and the error is thrown
+ */
+config::diff_t config::reload() {
+  config next{m_log, m_xrm, string{m_file}, string{m_barname}};
+  diff_t changes;
+
+  const auto compare = [&](const sectionmap_t& a, const sectionmap_t& b) {
+    for (auto&& section : a) {
+      auto other = b.find(section.first);
+      for (auto&& param : section.second) {
+        const entry* e{nullptr};
+        if (other != b.end()) {
+          auto it = other->second.find(param.first);
+          e = it != other->second.end() ? &it->second : nullptr;
+        }
+        if (e == nullptr || e->value != param.second.value || e->error != param.second.error) {
+          auto& keys = changes[section.first];
+          if (std::find(keys.begin(), keys.end(), param.first) == keys.end()) {
+            keys.emplace_back(param.first);
+          }
+        }
+      }
+    }
+  };
+
+  std::unique_lock<std::shared_timed_mutex> guard(m_lock);
+  compare(m_sections, next.m_sections);
+  compare(next.m_sections, m_sections);
+
+  // The list index points to the entries of the section map, which
+  // stay at the same address when the containers are swapped
+  std::swap(m_sections, next.m_sections);
+  std::swap(m_lists, next.m_lists);
+
+  m_log.info("config: Reloaded %s (%lu changed sections)", m_file, changes.size());
+
+  return changes;
+}
+
+/**
+ * Find parameter by section and key
+ */
+const config::entry* config::find(const string& section, const string& key) const {
+  auto it = m_sections.find(section);
+  if (it == m_sections.end()) {
+    return nullptr;
+  }
+  auto it2 = it->second.find(key);
+  if (it2 == it->second.end()) {
+    return nullptr;
+  }
+  return &it2->second;
+}
+
+/**
+ * Find list parameter (key-0, key-1, ...) by section and key
+ */
+const vector<const config::entry*>* config::find_list(const string& section, const string& key) const {
+  auto it = m_lists.find(section);
+  if (it == m_lists.end()) {
+    return nullptr;
+  }
+  auto it2 = it->second.find(key);
+  if (it2 == it->second.end()) {
+    return nullptr;
+  }
+  return &it2->second;
+}
+
 /**
  * Parse key/value pairs from the configuration file
  */
 void config::parse_file() {
   std::ifstream in(m_file);
   string line;
-  string section;
+  valuemap_t* section{nullptr};
   uint32_t lineno{0};
 
+  const auto trimmed = [](const string& str, size_t begin, size_t end) {
+    while (begin < end && str[begin] == ' ') {
+      begin++;
+    }
+    while (end > begin && str[end - 1] == ' ') {
+      end--;
+    }
+    return str.substr(begin, end - begin);
+  };
+
   while (std::getline(in, line)) {
     lineno++;
 
-    line = string_util::replace_all(line, "\t", "");
+    line.erase(std::remove(line.begin(), line.end(), '\t'), line.end());
 
     // Ignore empty lines and comments
     if (line.empty() || line[0] == ';' || line[0] == '#') {
@@ -97,9 +238,9 @@ void config::parse_file() {
 
     // New section
     if (line[0] == '[' && line[line.length() - 1] == ']') {
-      section = line.substr(1, line.length() - 2);
+      section = line.length() > 2 ? &m_sections[line.substr(1, line.length() - 2)] : nullptr;
       continue;
-    } else if (section.empty()) {
+    } else if (section == nullptr) {
       continue;
     }
 
@@ -110,23 +251,20 @@ void config::parse_file() {
       continue;
     }
 
-    string key{forward<string>(string_util::trim(forward<string>(line.substr(0, equal_pos)), ' '))};
-    string value;
+    string key{trimmed(line, 0, equal_pos)};
+    string value{trimmed(line, equal_pos + 1, line.size())};
 
-    auto it = m_sections[section].find(key);
-    if (it != m_sections[section].end()) {
+    auto it = section->find(key);
+    if (it != section->end()) {
       throw key_error("Duplicate key name \"" + key + "\" defined on line " + to_string(lineno));
     }
 
-    if (equal_pos + 1 < line.size()) {
-      value = forward<string>(string_util::trim(line.substr(equal_pos + 1), ' '));
-      size_t len{value.size()};
-      if (len > 2 && value[0] == '"' && value[len - 1] == '"') {
-        value.erase(len - 1, 1).erase(0, 1);
-      }
+    size_t len{value.size()};
+    if (len > 2 && value[0] == '"' && value[len - 1] == '"') {
+      value.erase(len - 1, 1).erase(0, 1);
     }
 
-    m_sections[section].emplace_hint(it, move(key), move(value));
+    section->emplace_hint(it, move(key), entry{move(value)});
   }
 }
 
@@ -138,42 +276,311 @@ void config::parse_file() {
  *   inherit = base/section
  */
 void config::copy_inherited() {
+  std::unordered_map<string, bool> visited;
+
+  for (auto&& section : m_sections) {
+    copy_inherited(section.first, visited);
+  }
+
+  // Inherited parameters may be the target of references
+  // that were followed while looking up the base sections
   for (auto&& section : m_sections) {
     for (auto&& param : section.second) {
-      if (param.first.compare(0, strlen(KEY_INHERIT), KEY_INHERIT) == 0) {
-        // Get name of base section
-        auto inherit = param.second;
-        if ((inherit = dereference<string>(section.first, param.first, inherit, inherit)).empty()) {
-          throw value_error("[" + section.first + "." + KEY_INHERIT + "] requires a value");
-        }
+      param.second.status = entry::state::UNRESOLVED;
+      param.second.error.clear();
+    }
+  }
+}
 
-        // Find and validate base section
-        auto base_section = m_sections.find(inherit);
-        if (base_section == m_sections.end()) {
-          throw value_error("[" + section.first + "." + KEY_INHERIT + "] invalid reference \"" + inherit + "\"");
-        }
+/**
+ * Copy the missing parameters of given section, making
+ * sure its base sections have been completed first
+ */
+void config::copy_inherited(const string& section, std::unordered_map<string, bool>& visited) {
+  auto it = visited.find(section);
+  if (it != visited.end()) {
+    if (!it->second) {
+      throw value_error("[" + section + "." + KEY_INHERIT + "] cyclic inheritance");
+    }
+    return;
+  }
 
-        m_log.trace("config: Copying missing params (sub=\"%s\", base=\"%s\")", section.first, inherit);
+  visited.emplace(section, false);
 
-        // Iterate the base and copy the parameters
-        // that hasn't been defined for the sub-section
-        for (auto&& base_param : base_section->second) {
-          valuemap_t::const_iterator iter;
-          section.second.insert(make_pair(base_param.first, base_param.second));
-        }
+  auto& values = m_sections.at(section);
+  vector<string> bases;
+
+  for (auto&& param : values) {
+    if (param.first.compare(0, strlen(KEY_INHERIT), KEY_INHERIT) == 0) {
+      // Get name of base section
+      resolve(section, param.first, param.second);
+      auto inherit = param.second.value;
+      if (inherit.empty()) {
+        throw value_error("[" + section + "." + KEY_INHERIT + "] requires a value");
+      }
+
+      // Validate base section
+      if (m_sections.find(inherit) == m_sections.end()) {
+        throw value_error("[" + section + "." + KEY_INHERIT + "] invalid reference \"" + inherit + "\"");
       }
+
+      bases.emplace_back(move(inherit));
+    }
+  }
+
+  for (auto&& base : bases) {
+    copy_inherited(base, visited);
+
+    m_log.trace("config: Copying missing params (sub=\"%s\", base=\"%s\")", section, base);
+
+    // Iterate the base and copy the parameters
+    // that hasn't been defined for the sub-section
+    for (auto&& base_param : m_sections.at(base)) {
+      values.emplace(base_param.first, entry{string{base_param.second.raw}});
     }
   }
+
+  visited[section] = true;
 }
 
-template <>
-string config::convert(string&& value) const {
-  return forward<string>(value);
+/**
+ * Resolve the references of all parameters
+ *
+ * Invalid references are reported when the
+ * parameter is requested
+ */
+void config::resolve_all() {
+  for (auto&& section : m_sections) {
+    for (auto&& param : section.second) {
+      param.second.status = entry::state::UNRESOLVED;
+      param.second.error.clear();
+      param.second.cache.clear();
+    }
+  }
+
+  for (auto&& section : m_sections) {
+    for (auto&& param : section.second) {
+      try {
+        resolve(section.first, param.first, param.second);
+      } catch (const value_error& err) {
+        m_log.trace("config: %s", err.what());
+      }
+    }
+  }
+}
+
+/**
+ * Map list parameters (key-0, key-1, ...) to their base key
+ */
+void config::index_lists() {
+  m_lists.clear();
+
+  for (auto&& section : m_sections) {
+    index_lists(section.first);
+  }
+}
+
+/**
+ * Map list parameters of given section to their base key
+ */
+void config::index_lists(const string& section) {
+  std::unordered_map<string, std::map<size_t, const entry*>> candidates;
+
+  m_lists.erase(section);
+
+  for (auto&& param : m_sections.at(section)) {
+    const string& key{param.first};
+    size_t pos{key.rfind('-')};
+
+    if (pos == string::npos || pos + 1 == key.size() ||
+        key.find_first_not_of("0123456789", pos + 1) != string::npos) {
+      continue;
+    }
+
+    // Only accept the canonical form of the index, i.e. key-1 but not key-01
+    size_t index{std::strtoul(key.c_str() + pos + 1, nullptr, 10)};
+    if (key.compare(pos + 1, string::npos, to_string(index)) != 0) {
+      continue;
+    }
+
+    candidates[key.substr(0, pos)].emplace(index, &param.second);
+  }
+
+  for (auto&& list : candidates) {
+    vector<const entry*> entries;
+    for (auto&& item : list.second) {
+      if (item.first != entries.size()) {
+        break;
+      }
+      entries.emplace_back(item.second);
+    }
+    if (!entries.empty()) {
+      m_lists[section].emplace(list.first, move(entries));
+    }
+  }
+}
+
+/**
+ * Resolve parameter value, following references
+ * to other parameters
+ */
+void config::resolve(const string& section, const string& key, entry& e) {
+  if (e.status == entry::state::RESOLVING) {
+    throw value_error("Cyclic reference defined at [" + section + "." + key + "]");
+  } else if (e.status == entry::state::UNRESOLVED) {
+    e.status = entry::state::RESOLVING;
+    try {
+      e.value = dereference(section, key, e.raw);
+    } catch (const value_error& err) {
+      e.error = err.what();
+    }
+    e.status = entry::state::RESOLVED;
+  }
+
+  if (!e.error.empty()) {
+    throw value_error(e.error);
+  }
+}
+
+/**
+ * Get the parameter a raw value refers to, if it is
+ * a reference to another parameter (${section.key})
+ */
+const config::entry* config::referenced(const string& section, const string& raw) const {
+  if (raw.size() < 3 || raw.compare(0, 2, "${") != 0 || raw.back() != '}') {
+    return nullptr;
+  }
+
+  auto path = raw.substr(2, raw.length() - 3);
+  size_t pos{path.find('.')};
+
+  if (pos == string::npos || path.compare(0, 4, "env:") == 0 || path.compare(0, 5, "xrdb:") == 0 ||
+      path.compare(0, 5, "file:") == 0) {
+    return nullptr;
+  }
+
+  return find(reference_section(path.substr(0, pos), section), path.substr(pos + 1));
+}
+
+/**
+ * Expand the section aliases (BAR, root, self) of a reference
+ */
+string config::reference_section(string section, const string& current_section) const {
+  section = string_util::replace(section, "BAR", this->section(), 0, 3);
+  section = string_util::replace(section, "root", this->section(), 0, 4);
+  return string_util::replace(section, "self", current_section, 0, 4);
+}
+
+/**
+ * Dereference value reference
+ */
+string config::dereference(const string& section, const string& key, const string& var) {
+  if (var.size() < 3 || var.compare(0, 2, "${") != 0 || var.back() != '}') {
+    return var;
+  }
+
+  auto path = var.substr(2, var.length() - 3);
+  size_t pos;
+
+  if (path.compare(0, 4, "env:") == 0) {
+    return dereference_env(path.substr(4));
+  } else if (path.compare(0, 5, "xrdb:") == 0) {
+    return dereference_xrdb(path.substr(5), var);
+  } else if (path.compare(0, 5, "file:") == 0) {
+    return dereference_file(path.substr(5), var);
+  } else if ((pos = path.find('.')) != string::npos) {
+    return dereference_local(path.substr(0, pos), path.substr(pos + 1), section);
+  } else {
+    throw value_error("Invalid reference defined at [" + section + "." + key + "]");
+  }
+}
+
+/**
+ * Dereference local value reference defined using:
+ *  ${root.key}
+ *  ${self.key}
+ *  ${section.key}
+ */
+string config::dereference_local(string section, const string& key, const string& current_section) {
+  if (section == "BAR") {
+    m_log.warn("${BAR.key} is deprecated. Use ${root.key} instead");
+  }
+
+  section = reference_section(move(section), current_section);
+
+  auto it = m_sections.find(section);
+  if (it != m_sections.end()) {
+    auto it2 = it->second.find(key);
+    if (it2 != it->second.end()) {
+      resolve(section, key, it2->second);
+      return it2->second.value;
+    }
+  }
+
+  throw value_error("Unexisting reference defined [" + section + "." + key + "]");
+}
+
+/**
+ * Dereference environment variable reference defined using:
+ *  ${env:key}
+ *  ${env:key:fallback value}
+ */
+string config::dereference_env(string var) const {
+  size_t pos;
+  string env_default{""};
+
+  if ((pos = var.find(":")) != string::npos) {
+    env_default = var.substr(pos + 1);
+    var.erase(pos);
+  }
+
+  if (env_util::has(var.c_str())) {
+    string env_value{env_util::get(var.c_str())};
+    m_log.info("Found matching environment variable ${" + var + "} with the value \"" + env_value + "\"");
+    return env_value;
+  } else if (!env_default.empty()) {
+    m_log.info("The environment variable ${" + var + "} is undefined or empty, using defined fallback value \"" +
+               env_default + "\"");
+  } else {
+    m_log.info("The environment variable ${" + var + "} is undefined or empty");
+  }
+
+  return env_default;
+}
+
+/**
+ * Dereference X resource db value defined using:
+ *  ${xrdb:key}
+ *  ${xrdb:key:fallback value}
+ */
+string config::dereference_xrdb(string var, const string& fallback) const {
+  size_t pos;
+
+  if ((pos = var.find(":")) != string::npos) {
+    return m_xrm.get_string(var.substr(0, pos), var.substr(pos + 1));
+  }
+
+  string str{m_xrm.get_string(var, "")};
+  return str.empty() ? fallback : str;
+}
+
+/**
+ * Dereference file reference by reading its contents
+ *  ${file:/absolute/file/path}
+ */
+string config::dereference_file(string var, const string& fallback) const {
+  string filename{move(var)};
+
+  if (file_util::exists(filename)) {
+    return string_util::trim(file_util::contents(filename), '\n');
+  }
+
+  return fallback;
 }
 
 template <>
-const char* config::convert(string&& value) const {
-  return value.c_str();
+string config::convert(string&& value) const {
+  return forward<string>(value);
 }
 
 template <>
@@ -1,10 +1,14 @@
+#include <algorithm>
 #include <csignal>
 
 #include "components/bar.hpp"
 #include "components/config.hpp"
 #include "components/controller.hpp"
+#include "components/eventqueue.hpp"
 #include "components/ipc.hpp"
 #include "components/logger.hpp"
+#include "components/metrics.hpp"
+#include "components/profiler.hpp"
 #include "components/renderer.hpp"
 #include "components/types.hpp"
 #include "events/signal.hpp"
@@ -13,6 +17,7 @@
 #include "modules/meta/event_handler.hpp"
 #include "modules/meta/factory.hpp"
 #include "utils/command.hpp"
+#include "utils/concurrency.hpp"
 #include "utils/factory.hpp"
 #include "utils/inotify.hpp"
 #include "utils/string.hpp"
@@ -27,11 +32,15 @@ POLYBAR_NS
 
 array<int, 2> g_eventpipe{{-1, -1}};
 sig_atomic_t g_reload{0};
+sig_atomic_t g_reconfigure{0};
 sig_atomic_t g_terminate{0};
 
 void interrupt_handler(int signum) {
-  g_terminate = 1;
-  g_reload = (signum == SIGUSR1);
+  if (signum == SIGUSR1) {
+    g_reconfigure = 1;
+  } else {
+    g_terminate = 1;
+  }
   if (write(g_eventpipe[PIPE_WRITE], &g_terminate, 1) == -1) {
     throw system_error("Failed to write to eventpipe");
   }
@@ -39,27 +48,44 @@ void interrupt_handler(int signum) {
 
 /**
  * Build controller instance
+ *
+ * All bars are hosted by the same process, sharing
+ * the X connection, the fonts and the modules
  */
-controller::make_type controller::make(unique_ptr<ipc>&& ipc, unique_ptr<inotify_watch>&& config_watch) {
+controller::make_type controller::make(
+    const vector<string>& bars, unique_ptr<ipc>&& ipc, unique_ptr<inotify_watch>&& config_watch) {
+  vector<unique_ptr<bar>> instances;
+
+  for (auto&& name : bars) {
+    instances.emplace_back(profiler::make().measure("bar/" + name + ": create", [&] { return bar::make(name); }));
+  }
+
   return factory_util::unique<controller>(connection::make(), signal_emitter::make(), logger::make(), config::make(),
-      bar::make(), forward<decltype(ipc)>(ipc), forward<decltype(config_watch)>(config_watch));
+      move(instances), forward<decltype(ipc)>(ipc), forward<decltype(config_watch)>(config_watch));
 }
 
 /**
  * Construct controller
  */
 controller::controller(connection& conn, signal_emitter& emitter, const logger& logger, const config& config,
-    unique_ptr<bar>&& bar, unique_ptr<ipc>&& ipc, unique_ptr<inotify_watch>&& confwatch)
+    vector<unique_ptr<bar>>&& bars, unique_ptr<ipc>&& ipc, unique_ptr<inotify_watch>&& confwatch)
     : m_connection(conn)
     , m_sig(emitter)
     , m_log(logger)
     , m_conf(config)
-    , m_bar(forward<decltype(bar)>(bar))
+    , m_bars(forward<decltype(bars)>(bars))
     , m_ipc(forward<decltype(ipc)>(ipc))
     , m_confwatch(forward<decltype(confwatch)>(confwatch)) {
   m_swallow_input = m_conf.get("settings", "throttle-input-for", m_swallow_input);
-  m_swallow_limit = m_conf.deprecated("settings", "eventqueue-swallow", "throttle-output", m_swallow_limit);
-  m_swallow_update = m_conf.deprecated("settings", "eventqueue-swallow-time", "throttle-output-for", m_swallow_update);
+
+  m_conf.warn_deprecated("settings", "throttle-output", "max-framerate");
+  m_conf.warn_deprecated("settings", "throttle-output-for", "max-framerate");
+  m_conf.warn_deprecated("settings", "eventqueue-swallow", "max-framerate");
+  m_conf.warn_deprecated("settings", "eventqueue-swallow-time", "max-framerate");
+
+  auto framerate = m_conf.get("settings", "max-framerate", 60U);
+  auto interval = framerate ? chrono::microseconds{1000000U / framerate} : chrono::microseconds::zero();
+  m_queue = eventqueue::make(interval);
 
   if (pipe(g_eventpipe.data()) == 0) {
     m_queuefd[PIPE_READ] = make_unique<file_descriptor>(g_eventpipe[PIPE_READ]);
@@ -79,41 +105,11 @@ controller::controller(connection& conn, signal_emitter& emitter, const logger&
   sigaction(SIGALRM, &act, nullptr);
 
   m_log.trace("controller: Setup user-defined modules");
-  size_t created_modules{0};
-
-  for (int i = 0; i < 3; i++) {
-    alignment align{static_cast<alignment>(i + 1)};
-    string configured_modules;
-
-    if (align == alignment::LEFT) {
-      configured_modules = m_conf.get(m_conf.section(), "modules-left", ""s);
-    } else if (align == alignment::CENTER) {
-      configured_modules = m_conf.get(m_conf.section(), "modules-center", ""s);
-    } else if (align == alignment::RIGHT) {
-      configured_modules = m_conf.get(m_conf.section(), "modules-right", ""s);
-    }
-
-    for (auto& module_name : string_util::split(configured_modules, ' ')) {
-      if (module_name.empty()) {
-        continue;
-      }
-
-      try {
-        auto type = m_conf.get("module/" + module_name, "type");
+  vector<modules::module_interface*> created_modules;
 
-        if (type == "custom/ipc" && !m_ipc) {
-          throw application_error("Inter-process messaging needs to be enabled");
-        }
-
-        m_modules[align].emplace_back(make_module(move(type), m_bar->settings(), module_name));
-        created_modules++;
-      } catch (const runtime_error& err) {
-        m_log.err("Disabling module \"%s\" (reason: %s)", module_name, err.what());
-      }
-    }
-  }
+  profiler::make().measure("modules: construct", [&] { setup_modules({}, created_modules); });
 
-  if (!created_modules) {
+  if (created_modules.empty()) {
     throw application_error("No modules created");
   }
 }
@@ -130,17 +126,10 @@ controller::~controller() {
   m_log.trace("controller: Detach signal receiver");
   m_sig.detach(this);
 
+  stop_rendering();
+
   m_log.trace("controller: Stop modules");
-  for (auto&& block : m_modules) {
-    for (auto&& module : block.second) {
-      auto module_name = module->name();
-      auto cleanup_ms = time_util::measure([&module] {
-        module->stop();
-        module.reset();
-      });
-      m_log.info("Deconstruction of %s took %lu ms.", module_name, cleanup_ms);
-    }
-  }
+  stop_modules(move(m_modules));
 }
 
 /**
@@ -155,31 +144,12 @@ bool controller::run(bool writeback) {
 
   m_sig.attach(this);
 
-  size_t started_modules{0};
-  for (const auto& block : m_modules) {
-    for (const auto& module : block.second) {
-      auto inp_handler = dynamic_cast<input_handler*>(&*module);
-      auto evt_handler = dynamic_cast<event_handler_interface*>(&*module);
-
-      if (inp_handler != nullptr) {
-        m_inputhandlers.emplace_back(inp_handler);
-      }
-
-      if (evt_handler != nullptr) {
-        evt_handler->connect(m_connection);
-      }
-
-      try {
-        m_log.info("Starting %s", module->name());
-        module->start();
-        started_modules++;
-      } catch (const application_error& err) {
-        m_log.err("Failed to start '%s' (reason: %s)", module->name(), err.what());
-      }
-    }
+  vector<modules::module_interface*> modules;
+  for (const auto& module : m_modules) {
+    modules.emplace_back(module.second.get());
   }
 
-  if (!started_modules) {
+  if (!profiler::make().measure("modules: start", [&] { return start_modules(modules); })) {
     throw application_error("No modules started");
   }
 
@@ -187,31 +157,300 @@ bool controller::run(bool writeback) {
 
   m_connection.flush();
 
+  if (profiler::make().enabled()) {
+    profiler::make().report();
+  }
+
+  if (!m_writeback) {
+    m_render_thread = thread(&controller::process_renderqueue, this);
+  }
+
   m_event_thread = thread(&controller::process_eventqueue, this);
 
   read_events();
 
+  // Pending events are discarded, the worker stops as soon as it returns to the queue
   if (m_event_thread.joinable()) {
-    enqueue(make_quit_evt(static_cast<bool>(g_reload)));
+    m_queue->close();
     m_event_thread.join();
   }
 
+  stop_rendering();
+
   m_log.warn("Termination signal received, shutting down...");
 
   return !g_reload;
 }
 
+/**
+ * Create the modules configured for the bars
+ *
+ * Bars that list the same module section share a single instance,
+ * which is created using the settings of the first bar listing it.
+ * Modules whose output depends on the monitor get one instance per
+ * monitor instead.
+ *
+ * Running modules whose section is not listed in `changed` are
+ * kept instead of being created again. Newly created modules are
+ * added to `created` and the modules that are no longer used
+ * are returned to the caller
+ */
+modulemap_t controller::setup_modules(const vector<string>& changed, vector<modules::module_interface*>& created) {
+  struct module_slot {
+    string name;
+    string type;
+    size_t bar_index;
+    bool reuse;
+    module_t module;
+  };
+  std::map<string, module_slot> slots;
+  vector<std::map<alignment, vector<string>>> layouts(m_bars.size());
+  vector<shared_ptr<const bar_settings>> bar_opts;
+
+  for (auto&& instance : m_bars) {
+    bar_opts.emplace_back(instance->settings());
+  }
+
+  for (size_t index = 0; index < m_bars.size(); index++) {
+    string bs{m_bars[index]->section()};
+
+    for (int i = 0; i < 3; i++) {
+      alignment align{static_cast<alignment>(i + 1)};
+      string configured_modules;
+
+      if (align == alignment::LEFT) {
+        configured_modules = m_conf.get(bs, "modules-left", ""s);
+      } else if (align == alignment::CENTER) {
+        configured_modules = m_conf.get(bs, "modules-center", ""s);
+      } else if (align == alignment::RIGHT) {
+        configured_modules = m_conf.get(bs, "modules-right", ""s);
+      }
+
+      for (auto& module_name : string_util::split(configured_modules, ' ')) {
+        if (module_name.empty()) {
+          continue;
+        }
+
+        try {
+          auto type = m_conf.get("module/" + module_name, "type");
+
+          if (type == "custom/ipc" && !m_ipc) {
+            throw application_error("Inter-process messaging needs to be enabled");
+          }
+
+          string key{"module/" + module_name};
+
+          if (make_module_per_monitor(type)) {
+            key += "@" + bar_opts[index]->monitor->name;
+          }
+
+          if (slots.find(key) == slots.end()) {
+            bool reuse{false};
+
+            if (std::find(changed.begin(), changed.end(), "module/" + module_name) == changed.end()) {
+              auto it = m_modules.find(key);
+              reuse = it != m_modules.end() && it->second->running();
+            }
+
+            slots.emplace(key, module_slot{module_name, move(type), index, reuse, nullptr});
+          }
+
+          layouts[index][align].emplace_back(move(key));
+        } catch (const runtime_error& err) {
+          m_log.err("Disabling module \"%s\" (reason: %s)", module_name, err.what());
+        }
+      }
+    }
+  }
+
+  auto& prof = profiler::make();
+
+  auto construct = [&](module_slot& slot) {
+    try {
+      slot.module.reset(prof.measure("module/" + slot.name + ": construct",
+          [&] { return make_module(string{slot.type}, *bar_opts[slot.bar_index], slot.name); }));
+    } catch (const runtime_error& err) {
+      m_log.err("Disabling module \"%s\" (reason: %s)", slot.name, err.what());
+    }
+  };
+
+  // Modules that touch shared state are created first, on this thread,
+  // the rest are spread across a pool of worker threads
+  vector<module_slot*> concurrent;
+  for (auto&& slot : slots) {
+    if (slot.second.reuse) {
+      continue;
+    } else if (make_module_concurrently(slot.second.type)) {
+      concurrent.emplace_back(&slot.second);
+    } else {
+      construct(slot.second);
+    }
+  }
+  concurrency_util::parallel_for(concurrent.size(), [&](size_t i) { construct(*concurrent[i]); });
+
+  modulemap_t modules;
+
+  for (auto&& slot : slots) {
+    if (!slot.second.reuse && slot.second.module) {
+      created.emplace_back(slot.second.module.get());
+    }
+  }
+
+  std::lock_guard<std::mutex> guard(m_modulelock);
+
+  for (auto&& slot : slots) {
+    if (slot.second.reuse) {
+      modules.emplace(slot.first, move(m_modules[slot.first]));
+    } else if (slot.second.module) {
+      modules.emplace(slot.first, move(slot.second.module));
+    }
+  }
+
+  std::swap(m_modules, modules);
+
+  m_layouts.assign(m_bars.size(), layout_t{});
+  m_segments.assign(m_bars.size(), {});
+  for (size_t index = 0; index < m_bars.size(); index++) {
+    for (auto&& block : layouts[index]) {
+      for (auto&& key : block.second) {
+        auto it = m_modules.find(key);
+        if (it != m_modules.end()) {
+          m_layouts[index][block.first].emplace_back(it->second.get());
+        }
+      }
+    }
+  }
+
+  m_router.clear();
+  for (const auto& module : m_modules) {
+    auto inp_handler = dynamic_cast<input_handler*>(module.second.get());
+    if (inp_handler != nullptr) {
+      m_router.add(module.second->id(), inp_handler);
+    }
+  }
+
+  // Return the modules that were not reused
+  for (auto it = modules.begin(); it != modules.end();) {
+    if (it->second) {
+      it++;
+    } else {
+      it = modules.erase(it);
+    }
+  }
+
+  return modules;
+}
+
+/**
+ * Connect the event handlers of given modules and start them
+ */
+size_t controller::start_modules(const vector<modules::module_interface*>& modules) {
+  for (auto&& module : modules) {
+    auto evt_handler = dynamic_cast<event_handler_interface*>(module);
+
+    if (evt_handler != nullptr) {
+      evt_handler->connect(m_connection);
+    }
+  }
+
+  auto& prof = profiler::make();
+  atomic<size_t> started_modules{0};
+
+  concurrency_util::parallel_for(modules.size(), [&](size_t i) {
+    auto module = modules[i];
+    try {
+      m_log.info("Starting %s", module->name());
+      prof.measure("module/" + module->name() + ": start", [&] { module->start(); });
+      started_modules++;
+    } catch (const application_error& err) {
+      m_log.err("Failed to start '%s' (reason: %s)", module->name(), err.what());
+    }
+  });
+
+  return started_modules;
+}
+
+/**
+ * Stop and destroy given modules
+ */
+void controller::stop_modules(modulemap_t&& modules) {
+  for (auto&& entry : modules) {
+    auto& module = entry.second;
+    auto evt_handler = dynamic_cast<event_handler_interface*>(&*module);
+    auto module_name = module->name();
+
+    if (evt_handler != nullptr) {
+      evt_handler->disconnect(m_connection);
+    }
+
+    auto cleanup_ms = time_util::measure([&module] {
+      module->stop();
+      module.reset();
+    });
+    m_log.info("Deconstruction of %s took %lu ms.", module_name, cleanup_ms);
+  }
+}
+
+/**
+ * Apply changes made to the configuration without restarting
+ * the application
+ *
+ * Only the modules whose section changed are created again, the
+ * bar windows and their fonts are kept. Returns false if the changes
+ * require a restart
+ */
+bool controller::reconfigure() {
+  m_log.info("Reloading configuration");
+
+  config::diff_t changes;
+
+  try {
+    changes = const_cast<config&>(m_conf).reload();
+  } catch (const exception& err) {
+    m_log.err("Failed to reload configuration, keeping the current one (reason: %s)", err.what());
+    return true;
+  }
+
+  vector<string> changed_modules;
+  vector<string> bar_sections;
+
+  for (auto&& instance : m_bars) {
+    bar_sections.emplace_back(instance->section());
+  }
+
+  for (auto&& section : changes) {
+    if (section.first.compare(0, 7, "module/") == 0) {
+      changed_modules.emplace_back(section.first);
+    } else if (section.first == "settings" || section.first == "global/wm") {
+      m_log.info("Parameters in [%s] changed, restart required", section.first);
+      return false;
+    } else if (std::find(bar_sections.begin(), bar_sections.end(), section.first) != bar_sections.end()) {
+      for (auto&& key : section.second) {
+        if (key != "modules-left" && key != "modules-center" && key != "modules-right") {
+          m_log.info("Parameter `%s.%s` changed, restart required", section.first, key);
+          return false;
+        }
+      }
+    }
+  }
+
+  vector<modules::module_interface*> created_modules;
+  auto unused_modules = setup_modules(changed_modules, created_modules);
+
+  stop_modules(move(unused_modules));
+  start_modules(created_modules);
+
+  m_log.info("Configuration reloaded (%lu modules created)", created_modules.size());
+  enqueue(make_update_evt(true));
+
+  return true;
+}
+
 /**
  * Enqueue event
  */
 bool controller::enqueue(event&& evt) {
-  if (!m_queue.enqueue(forward<decltype(evt)>(evt))) {
-    m_log.warn("Failed to enqueue event");
-    return false;
-  }
-  // if (write(g_eventpipe[PIPE_WRITE], " ", 1) == -1) {
-  //   m_log.err("Failed to write to eventpipe (reason: %s)", strerror(errno));
-  // }
+  m_queue->push(forward<decltype(evt)>(evt));
   return true;
 }
 
@@ -220,8 +459,12 @@ bool controller::enqueue(event&& evt) {
  */
 bool controller::enqueue(string&& input_data) {
   if (!m_inputdata.empty()) {
+    static const size_t counter{metrics::make().counter("controller: swallowed input (pending)")};
+    metrics::make().increment(counter);
     m_log.trace("controller: Swallowing input event (pending data)");
   } else if (chrono::system_clock::now() - m_swallow_input < m_lastinput) {
+    static const size_t counter{metrics::make().counter("controller: swallowed input (throttled)")};
+    metrics::make().increment(counter);
     m_log.trace("controller: Swallowing input event (throttled)");
   } else {
     m_inputdata = forward<string>(input_data);
@@ -238,7 +481,6 @@ void controller::read_events() {
 
   int fd_connection{-1};
   int fd_confwatch{-1};
-  int fd_ipc{-1};
 
   vector<int> fds;
   fds.emplace_back(*m_queuefd[PIPE_READ]);
@@ -250,10 +492,6 @@ void controller::read_events() {
     fds.emplace_back((fd_confwatch = m_confwatch->get_file_descriptor()));
   }
 
-  if (m_ipc) {
-    fds.emplace_back((fd_ipc = m_ipc->get_file_descriptor()));
-  }
-
   while (!g_terminate) {
     fd_set readfds{};
     FD_ZERO(&readfds);
@@ -264,12 +502,24 @@ void controller::read_events() {
       maxfd = std::max(maxfd, fd);
     }
 
+    // The set of connected ipc clients changes between iterations
+    vector<int> fds_ipc;
+    if (m_ipc) {
+      fds_ipc = m_ipc->get_file_descriptors();
+    }
+    for (auto&& fd : fds_ipc) {
+      FD_SET(fd, &readfds);
+      maxfd = std::max(maxfd, fd);
+    }
+
     // Wait until event is ready on one of the configured streams
     int events = select(maxfd + 1, &readfds, nullptr, nullptr, nullptr);
 
     // Check for errors
-    if (events == -1 || g_terminate || m_connection.connection_has_error()) {
+    if ((events == -1 && errno != EINTR) || g_terminate || m_connection.connection_has_error()) {
       break;
+    } else if (events == -1) {
+      FD_ZERO(&readfds);
     }
 
     // Process event on the internal fd
@@ -283,8 +533,7 @@ void controller::read_events() {
     // Process event on the config inotify watch fd
     if (fd_confwatch > -1 && FD_ISSET(fd_confwatch, &readfds) && m_confwatch->await_match()) {
       m_log.info("Configuration file changed");
-      g_terminate = 1;
-      g_reload = 1;
+      g_reconfigure = 1;
     }
 
     // Process event on the xcb connection fd
@@ -301,15 +550,74 @@ void controller::read_events() {
       }
     }
 
-    // Process event on the ipc fd
-    if (fd_ipc > -1 && FD_ISSET(fd_ipc, &readfds)) {
-      m_ipc->receive_message();
-      fds.erase(std::remove_if(fds.begin(), fds.end(), [fd_ipc](int fd) { return fd == fd_ipc; }), fds.end());
-      fds.emplace_back((fd_ipc = m_ipc->get_file_descriptor()));
+    // Process events on the ipc socket and client connections
+    for (auto&& fd : fds_ipc) {
+      if (FD_ISSET(fd, &readfds)) {
+        m_ipc->receive_message(fd);
+      }
+    }
+
+    // Apply configuration changes
+    if (g_reconfigure) {
+      g_reconfigure = 0;
+
+      if (!reconfigure()) {
+        g_terminate = 1;
+        g_reload = 1;
+      }
     }
   }
 }
 
+/**
+ * Render worker loop
+ *
+ * Draws the contents queued for each bar, so that drawing
+ * does not hold up the eventqueue. All bars are drawn by this
+ * thread, since renderers may share their font manager
+ */
+void controller::process_renderqueue() {
+  m_log.info("Starting render thread (thread-id=%lu)", this_thread::get_id());
+
+  std::unique_lock<std::mutex> guard(m_renderlock);
+
+  while (true) {
+    m_rendercond.wait(guard, [&] { return m_renderpending || m_renderstop; });
+
+    if (m_renderstop) {
+      break;
+    }
+
+    m_renderpending = false;
+    guard.unlock();
+
+    for (auto&& instance : m_bars) {
+      try {
+        instance->draw();
+      } catch (const exception& err) {
+        m_log.err("Failed to update bar contents (reason: %s)", err.what());
+      }
+    }
+
+    guard.lock();
+  }
+
+  m_log.info("Render thread done");
+}
+
+/**
+ * Stop the render worker and wait for it to finish the current frame
+ */
+void controller::stop_rendering() {
+  if (m_render_thread.joinable()) {
+    std::unique_lock<std::mutex> guard(m_renderlock);
+    m_renderstop = true;
+    guard.unlock();
+    m_rendercond.notify_one();
+    m_render_thread.join();
+  }
+}
+
 /**
  * Eventqueue worker loop
  */
@@ -318,10 +626,8 @@ void controller::process_eventqueue() {
 
   enqueue(make_update_evt(true));
 
-  while (!g_terminate) {
-    event evt{};
-    m_queue.wait_dequeue(evt);
-
+  event evt{};
+  while (!g_terminate && m_queue->pop(evt)) {
     if (g_terminate) {
       break;
     } else if (evt.type == event_type::QUIT) {
@@ -332,42 +638,12 @@ void controller::process_eventqueue() {
       }
     } else if (evt.type == event_type::INPUT) {
       process_inputdata();
-    } else if (evt.type == event_type::UPDATE && evt.flag) {
-      process_update(true);
+    } else if (evt.type == event_type::CHECK) {
+      process_check();
+    } else if (evt.type == event_type::UPDATE) {
+      process_update(evt.flag);
     } else {
-      event next{};
-      size_t swallowed{0};
-      while (swallowed++ < m_swallow_limit && m_queue.wait_dequeue_timed(next, m_swallow_update)) {
-        if (next.type == event_type::QUIT) {
-          evt = next;
-          break;
-        } else if (next.type == event_type::INPUT) {
-          evt = next;
-          break;
-        } else if (evt.type != next.type) {
-          enqueue(move(next));
-          break;
-        } else {
-          m_log.trace_x("controller: Swallowing event within timeframe");
-          evt = next;
-        }
-      }
-
-      if (evt.type == event_type::UPDATE) {
-        process_update(evt.flag);
-      } else if (evt.type == event_type::INPUT) {
-        process_inputdata();
-      } else if (evt.type == event_type::QUIT) {
-        if (evt.flag) {
-          on(signals::eventqueue::exit_reload{});
-        } else {
-          on(signals::eventqueue::exit_terminate{});
-        }
-      } else if (evt.type == event_type::CHECK) {
-        on(signals::eventqueue::check_state{});
-      } else {
-        m_log.warn("Unknown event type for enqueued event (%d)", evt.type);
-      }
+      m_log.warn("Unknown event type for enqueued event (%d)", evt.type);
     }
   }
 }
@@ -377,15 +653,15 @@ void controller::process_eventqueue() {
  */
 void controller::process_inputdata() {
   if (!m_inputdata.empty()) {
-    string cmd = m_inputdata;
+    string cmd{move(m_inputdata)};
     m_lastinput = chrono::time_point_cast<decltype(m_swallow_input)>(chrono::system_clock::now());
     m_inputdata.clear();
 
-    for (auto&& handler : m_inputhandlers) {
-      if (handler->input(string{cmd})) {
-        return;
-      }
+    std::unique_lock<std::mutex> guard(m_modulelock);
+    if (m_router.dispatch(cmd)) {
+      return;
     }
+    guard.unlock();
 
     try {
       m_log.info("Uncaught input event, forwarding to shell... (input: %s)", cmd);
@@ -408,17 +684,85 @@ void controller::process_inputdata() {
 
 /**
  * Process eventqueue update event
+ *
+ * The contents of each bar are built from the shared modules,
+ * which only rebuild their output once per change. Bars whose
+ * modules all kept their output are skipped unless forced
  */
 bool controller::process_update(bool force) {
-  const bar_settings& bar{m_bar->settings()};
+  static const size_t timer{metrics::make().timer("controller: update")};
+  metrics::probe probe{metrics::make(), timer};
+
+  vector<shared_ptr<const string>> contents;
+
+  std::unique_lock<std::mutex> guard(m_modulelock);
+  for (size_t i = 0; i < m_bars.size() && i < m_layouts.size(); i++) {
+    auto segments = collect_contents(m_layouts[i]);
+
+    if (force || segments != m_segments[i]) {
+      contents.emplace_back(make_shared<const string>(build_contents(*m_bars[i]->settings(), m_layouts[i], segments)));
+      m_segments[i] = move(segments);
+    } else {
+      contents.emplace_back();
+    }
+  }
+  guard.unlock();
+
+  for (size_t i = 0; i < contents.size(); i++) {
+    if (!contents[i]) {
+      continue;
+    } else if (!m_writeback) {
+      m_bars[i]->parse(move(contents[i]), force);
+    } else {
+      std::cout << *contents[i] << std::endl;
+    }
+  }
+
+  if (!m_writeback) {
+    std::unique_lock<std::mutex> render_guard(m_renderlock);
+    m_renderpending = true;
+    render_guard.unlock();
+    m_rendercond.notify_one();
+  }
+
+  return true;
+}
+
+/**
+ * Get the output of the modules shown by a bar, in layout order
+ *
+ * Modules that are stopped or have no output get an empty entry
+ */
+vector<shared_ptr<const string>> controller::collect_contents(const layout_t& layout) {
+  vector<shared_ptr<const string>> segments;
+
+  for (const auto& block : layout) {
+    for (const auto& module : block.second) {
+      shared_ptr<const string> output;
+      if (module->running() && (output = module->contents()) && output->empty()) {
+        output.reset();
+      }
+      segments.emplace_back(move(output));
+    }
+  }
+
+  return segments;
+}
+
+/**
+ * Join the output of the modules shown by a bar
+ */
+string controller::build_contents(
+    const bar_settings& bar, const layout_t& layout, const vector<shared_ptr<const string>>& segments) {
   string contents;
+  auto segment = segments.begin();
   string separator{bar.separator};
   string padding_left(bar.padding.left, ' ');
   string padding_right(bar.padding.right, ' ');
   string margin_left(bar.module_margin.left, ' ');
   string margin_right(bar.module_margin.right, ' ');
 
-  for (const auto& block : m_modules) {
+  for (const auto& block : layout) {
     string block_contents;
     bool is_left = false;
     bool is_center = false;
@@ -433,12 +777,8 @@ bool controller::process_update(bool force) {
     }
 
     for (const auto& module : block.second) {
-      if (!module->running()) {
-        continue;
-      }
-
-      string module_contents{module->contents()};
-      if (module_contents.empty()) {
+      const auto& output = *segment++;
+      if (!output) {
         continue;
       }
 
@@ -454,8 +794,7 @@ bool controller::process_update(bool force) {
         block_contents += margin_left;
       }
 
-      block_contents.reserve(module_contents.size());
-      block_contents += module_contents;
+      block_contents += *output;
     }
 
     if (block_contents.empty()) {
@@ -482,17 +821,7 @@ bool controller::process_update(bool force) {
     contents += string_util::replace_all(block_contents, "}%{", " ");
   }
 
-  try {
-    if (!m_writeback) {
-      m_bar->parse(move(contents), force);
-    } else {
-      std::cout << contents << std::endl;
-    }
-  } catch (const exception& err) {
-    m_log.err("Failed to update bar contents (reason: %s)", err.what());
-  }
-
-  return true;
+  return contents;
 }
 
 /**
@@ -521,7 +850,8 @@ bool controller::on(const signals::eventqueue::exit_terminate&) {
  * Process eventqueue reload event
  */
 bool controller::on(const signals::eventqueue::exit_reload&) {
-  raise(SIGUSR1);
+  g_reload = 1;
+  raise(SIGALRM);
   return true;
 }
 
@@ -529,16 +859,21 @@ bool controller::on(const signals::eventqueue::exit_reload&) {
  * Process eventqueue check event
  */
 bool controller::on(const signals::eventqueue::check_state&) {
-  for (const auto& block : m_modules) {
-    for (const auto& module : block.second) {
-      if (module->running()) {
-        return true;
-      }
+  return enqueue(make_check_evt());
+}
+
+/**
+ * Stop the application if no modules are running
+ */
+void controller::process_check() {
+  std::lock_guard<std::mutex> guard(m_modulelock);
+  for (const auto& module : m_modules) {
+    if (module.second->running()) {
+      return;
     }
   }
   m_log.warn("No running modules...");
   on(signals::eventqueue::exit_terminate{});
-  return true;
 }
 
 /**
@@ -586,8 +921,11 @@ bool controller::on(const signals::ipc::command& evt) {
     enqueue(make_quit_evt(false));
   } else if (command == "restart") {
     enqueue(make_quit_evt(true));
+  } else if (command == "reload") {
+    g_reconfigure = 1;
   } else {
     m_log.warn("\"%s\" is not a valid ipc command", command);
+    return false;
   }
 
   return true;
@@ -598,20 +936,27 @@ bool controller::on(const signals::ipc::command& evt) {
  */
 bool controller::on(const signals::ipc::hook& evt) {
   string hook{evt.cast()};
-
-  for (const auto& block : m_modules) {
-    for (const auto& module : block.second) {
-      if (!module->running()) {
-        continue;
-      }
-      auto ipc = dynamic_cast<ipc_module*>(module.get());
-      if (ipc != nullptr) {
-        ipc->on_message(hook);
+  bool matched{false};
+
+  // The hook commands run synchronously, so they are
+  // executed without holding up the module updates
+  vector<module_t> receivers;
+  {
+    std::lock_guard<std::mutex> guard(m_modulelock);
+    for (const auto& module : m_modules) {
+      if (module.second->running() && dynamic_cast<ipc_module*>(module.second.get()) != nullptr) {
+        receivers.emplace_back(module.second);
       }
     }
   }
 
-  return true;
+  for (auto&& module : receivers) {
+    if (static_cast<ipc_module*>(module.get())->on_message(hook)) {
+      matched = true;
+    }
+  }
+
+  return matched;
 }
 
 POLYBAR_NS_END
@@ -0,0 +1,130 @@
+#include "components/eventqueue.hpp"
+#include "components/metrics.hpp"
+#include "utils/factory.hpp"
+
+POLYBAR_NS
+
+/**
+ * Create instance
+ */
+eventqueue::make_type eventqueue::make(duration frame_interval) {
+  return factory_util::unique<eventqueue>(frame_interval);
+}
+
+/**
+ * Construct queue
+ */
+eventqueue::eventqueue(duration frame_interval) : m_interval(frame_interval) {}
+
+/**
+ * Add event to the queue, collapsing it with pending events of the same type
+ */
+void eventqueue::push(event&& evt) {
+  std::unique_lock<std::mutex> guard(m_lock);
+
+  if (evt.type == event_type::QUIT) {
+    m_quit = true;
+    m_reload = m_reload || evt.flag;
+  } else if (evt.type == event_type::INPUT) {
+    m_input++;
+  } else if (evt.type == event_type::CHECK) {
+    m_check = true;
+  } else if (evt.type == event_type::UPDATE) {
+    if (m_dirty) {
+      static const size_t counter{metrics::make().counter("eventqueue: coalesced updates")};
+      metrics::make().increment(counter);
+      m_coalesced++;
+    }
+    m_dirty = true;
+    m_force = m_force || evt.flag;
+    m_generation++;
+  } else {
+    return;
+  }
+
+  guard.unlock();
+  m_cond.notify_one();
+}
+
+/**
+ * Wait for the next event
+ *
+ * Returns false once the queue has been closed
+ */
+bool eventqueue::pop(event& evt) {
+  std::unique_lock<std::mutex> guard(m_lock);
+
+  while (!m_closed) {
+    clock::time_point wakeup{clock::time_point::max()};
+
+    if (next(evt, clock::now(), wakeup)) {
+      return true;
+    } else if (wakeup == clock::time_point::max()) {
+      m_cond.wait(guard);
+    } else {
+      m_cond.wait_until(guard, wakeup);
+    }
+  }
+
+  return false;
+}
+
+/**
+ * Wake up the consumer and stop handing out events
+ */
+void eventqueue::close() {
+  {
+    std::lock_guard<std::mutex> guard(m_lock);
+    m_closed = true;
+  }
+  m_cond.notify_all();
+}
+
+/**
+ * Get the number of update events received
+ */
+size_t eventqueue::generation() const {
+  std::lock_guard<std::mutex> guard(m_lock);
+  return m_generation;
+}
+
+/**
+ * Get the number of update events that were merged into a pending one
+ */
+size_t eventqueue::coalesced() const {
+  std::lock_guard<std::mutex> guard(m_lock);
+  return m_coalesced;
+}
+
+/**
+ * Take the most important pending event
+ *
+ * If only a paced update is pending, `wakeup` is set
+ * to the time when it is due
+ */
+bool eventqueue::next(event& evt, clock::time_point now, clock::time_point& wakeup) {
+  if (m_quit) {
+    m_quit = false;
+    evt = make_quit_evt(m_reload);
+  } else if (m_input > 0) {
+    m_input--;
+    evt = make_input_evt();
+  } else if (m_check) {
+    m_check = false;
+    evt = make_check_evt();
+  } else if (m_dirty && now - m_lastframe < m_interval) {
+    wakeup = m_lastframe + m_interval;
+    return false;
+  } else if (m_dirty) {
+    evt = make_update_evt(m_force);
+    m_dirty = false;
+    m_force = false;
+    m_lastframe = now;
+  } else {
+    return false;
+  }
+
+  return true;
+}
+
+POLYBAR_NS_END
@@ -1,8 +1,11 @@
-#include <fcntl.h>
-#include <sys/stat.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <algorithm>
 
+#include "components/action_router.hpp"
 #include "components/ipc.hpp"
 #include "components/logger.hpp"
+#include "components/metrics.hpp"
 #include "events/signal.hpp"
 #include "events/signal_emitter.hpp"
 #include "utils/factory.hpp"
@@ -11,6 +14,11 @@
 
 POLYBAR_NS
 
+/**
+ * Largest accepted request packet
+ */
+static constexpr size_t IPC_MESSAGE_SIZE{65536};
+
 /**
  * Create instance
  */
@@ -22,61 +30,238 @@ ipc::make_type ipc::make() {
  * Construct ipc handler
  */
 ipc::ipc(signal_emitter& emitter, const logger& logger) : m_sig(emitter), m_log(logger) {
-  m_path = string_util::replace(PATH_MESSAGING_FIFO, "%pid%", to_string(getpid()));
+  m_path = string_util::replace(PATH_MESSAGING_SOCKET, "%pid%", to_string(getpid()));
+
+  struct sockaddr_un addr {};
+  addr.sun_family = AF_UNIX;
 
-  if (mkfifo(m_path.c_str(), 0666) == -1) {
-    throw system_error("Failed to create ipc channel");
+  if (m_path.size() >= sizeof(addr.sun_path)) {
+    throw application_error("Path to ipc socket is too long: " + m_path);
+  }
+
+  m_path.copy(addr.sun_path, m_path.size());
+
+  int fd{socket(AF_UNIX, SOCK_SEQPACKET | SOCK_NONBLOCK | SOCK_CLOEXEC, 0)};
+  if (fd == -1) {
+    throw system_error("Failed to create ipc socket");
+  }
+
+  m_fd = make_unique<file_descriptor>(fd);
+
+  // Remove stale socket left behind by a previous process with the same pid
+  unlink(m_path.c_str());
+
+  if (bind(fd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) == -1) {
+    throw system_error("Failed to bind ipc socket");
+  } else if (listen(fd, SOMAXCONN) == -1) {
+    throw system_error("Failed to listen on ipc socket");
   }
 
   m_log.info("Created ipc channel at: %s", m_path);
-  m_fd = file_util::make_file_descriptor(m_path, O_RDONLY | O_NONBLOCK);
+  m_sig.attach(this);
 }
 
 /**
  * Deconstruct ipc handler
  */
 ipc::~ipc() {
+  m_sig.detach(this);
+
+  std::unique_lock<std::mutex> guard(m_mutex);
+  m_clients.clear();
+  guard.unlock();
+
   m_fd.reset();
 
   if (!m_path.empty()) {
-    m_log.trace("ipc: Removing file handle");
+    m_log.trace("ipc: Removing socket");
     unlink(m_path.c_str());
   }
 }
 
 /**
- * Receive available ipc messages and delegate valid events
+ * Get the file descriptors to watch for incoming data,
+ * i.e. the listening socket and all connected clients
+ */
+vector<int> ipc::get_file_descriptors() const {
+  std::lock_guard<std::mutex> guard(m_mutex);
+  vector<int> fds;
+  fds.reserve(m_clients.size() + 1);
+  fds.emplace_back(*m_fd);
+  for (auto&& c : m_clients) {
+    fds.emplace_back(*c.fd);
+  }
+  return fds;
+}
+
+/**
+ * Handle activity on given file descriptor
+ *
+ * New connections are accepted on the listening socket, clients
+ * get their queued requests processed and answered
  */
-void ipc::receive_message() {
-  m_log.info("Receiving ipc message");
+void ipc::receive_message(int fd) {
+  if (fd == *m_fd) {
+    return accept_clients();
+  }
 
-  char buffer[BUFSIZ]{'\0'};
-  ssize_t bytes_read{0};
+  std::unique_lock<std::mutex> guard(m_mutex);
+  if (std::find_if(m_clients.begin(), m_clients.end(), [fd](const client& c) { return *c.fd == fd; }) ==
+      m_clients.end()) {
+    return;
+  }
+  guard.unlock();
+
+  vector<char> buffer(IPC_MESSAGE_SIZE);
 
-  if ((bytes_read = read(*m_fd, &buffer, BUFSIZ)) == -1) {
-    m_log.err("Failed to read from ipc channel (err: %s)", strerror(errno));
-  } else if (bytes_read > 0) {
-    string payload{string_util::trim(string{buffer}, '\n')};
+  while (true) {
+    ssize_t bytes{recv(fd, buffer.data(), buffer.size(), MSG_TRUNC | MSG_DONTWAIT)};
+
+    if (bytes == -1 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) {
+      return;
+    } else if (bytes <= 0) {
+      return disconnect(fd);
+    }
 
-    if (payload.find(ipc_command::prefix) == 0) {
-      m_sig.emit(signals::ipc::command{payload.substr(strlen(ipc_command::prefix))});
+    string reply;
+    bool subscribe{false};
+
+    if (static_cast<size_t>(bytes) > buffer.size()) {
+      m_log.warn("Received ipc message exceeding %lu bytes", buffer.size());
+      reply = to_string(static_cast<int>(ipc_status::TOO_LONG)) + " message too long\n";
+    } else {
+      reply = process(string{buffer.data(), static_cast<size_t>(bytes)}, subscribe);
+    }
+
+    if (send(fd, reply.c_str(), reply.size(), MSG_NOSIGNAL | MSG_DONTWAIT) == -1) {
+      m_log.err("Failed to send ipc reply (err: %s)", strerror(errno));
+      return disconnect(fd);
+    }
+
+    if (subscribe) {
+      std::lock_guard<std::mutex> guard(m_mutex);
+      for (auto&& c : m_clients) {
+        if (*c.fd == fd) {
+          c.subscribed = true;
+        }
+      }
+    }
+  }
+}
+
+/**
+ * Accept all pending connections
+ */
+void ipc::accept_clients() {
+  int fd;
+  while ((fd = accept4(*m_fd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC)) != -1) {
+    m_log.trace("ipc: Client connected (fd=%i)", fd);
+    std::lock_guard<std::mutex> guard(m_mutex);
+    m_clients.emplace_back(client{make_unique<file_descriptor>(fd), false});
+  }
+}
+
+/**
+ * Close the connection to given client
+ */
+void ipc::disconnect(int fd) {
+  m_log.trace("ipc: Client disconnected (fd=%i)", fd);
+  std::lock_guard<std::mutex> guard(m_mutex);
+  m_clients.erase(std::remove_if(m_clients.begin(), m_clients.end(), [fd](const client& c) { return *c.fd == fd; }),
+      m_clients.end());
+}
+
+/**
+ * Run the requests contained in the message and build the reply
+ */
+string ipc::process(const string& message, bool& subscribe) {
+  string status;
+  string data;
+
+  const auto reply = [&](ipc_status code, const string& text) {
+    status += to_string(static_cast<int>(code)) + " " + text + "\n";
+  };
+
+  for (auto&& request : string_util::split(message, '\n')) {
+    string payload{string_util::trim(string{request}, ' ')};
+
+    if (payload.empty()) {
+      continue;
+    } else if (payload.find(ipc_command::prefix) == 0) {
+      if (m_sig.emit(signals::ipc::command{payload.substr(strlen(ipc_command::prefix))})) {
+        reply(ipc_status::OK, "ok");
+      } else {
+        reply(ipc_status::REJECTED, "invalid command");
+      }
     } else if (payload.find(ipc_hook::prefix) == 0) {
-      m_sig.emit(signals::ipc::hook{payload.substr(strlen(ipc_hook::prefix))});
+      if (m_sig.emit(signals::ipc::hook{payload.substr(strlen(ipc_hook::prefix))})) {
+        reply(ipc_status::OK, "ok");
+      } else {
+        reply(ipc_status::REJECTED, "no matching hook");
+      }
     } else if (payload.find(ipc_action::prefix) == 0) {
-      m_sig.emit(signals::ipc::action{payload.substr(strlen(ipc_action::prefix))});
-    } else if (!payload.empty()) {
+      if (m_sig.emit(signals::ipc::action{payload.substr(strlen(ipc_action::prefix))})) {
+        reply(ipc_status::OK, "ok");
+      } else {
+        reply(ipc_status::REJECTED, "invalid action");
+      }
+    } else if (payload == ipc_stats::prefix) {
+      data += metrics::make().report();
+      reply(ipc_status::OK, "ok");
+    } else if (payload == ipc_subscribe::prefix) {
+      subscribe = true;
+      reply(ipc_status::OK, "ok");
+    } else {
       m_log.warn("Received unknown ipc message: (payload=%s)", payload);
+      reply(ipc_status::UNKNOWN_TYPE, "unknown message type");
     }
   }
 
-  m_fd = file_util::make_file_descriptor(m_path, O_RDONLY | O_NONBLOCK);
+  if (!data.empty()) {
+    status += "\n" + data;
+  }
+
+  return status;
 }
 
 /**
- * Get the file descriptor to the ipc channel
+ * Send event to all subscribed clients
+ *
+ * Clients that do not keep up with the events are shut down. They
+ * are removed by the event loop once it sees the connection close,
+ * since events can be published from any thread
  */
-int ipc::get_file_descriptor() const {
-  return *m_fd;
+void ipc::publish(const string& name, const string& value) {
+  string packet{ipc_event::prefix + name + ":" + value};
+
+  std::lock_guard<std::mutex> guard(m_mutex);
+  for (auto&& c : m_clients) {
+    if (c.subscribed && send(*c.fd, packet.c_str(), packet.size(), MSG_NOSIGNAL | MSG_DONTWAIT) == -1) {
+      m_log.warn("Dropping ipc subscriber (err: %s)", strerror(errno));
+      shutdown(*c.fd, SHUT_RDWR);
+      c.subscribed = false;
+    }
+  }
+}
+
+bool ipc::on(const signals::ui::button_press& evt) {
+  publish("action", action_router::strip(evt.cast()));
+  return false;
+}
+
+bool ipc::on(const signals::ui::visibility_change& evt) {
+  publish("visibility", evt.cast() ? "1" : "0");
+  return false;
+}
+
+bool ipc::on(const signals::ui::shade_window&) {
+  publish("shade", "1");
+  return false;
+}
+
+bool ipc::on(const signals::ui::unshade_window&) {
+  publish("shade", "0");
+  return false;
 }
 
 POLYBAR_NS_END
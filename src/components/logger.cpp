@@ -1,4 +1,6 @@
+#include <sys/uio.h>
 #include <unistd.h>
+#include <cstring>
 
 #include "components/logger.hpp"
 #include "errors.hpp"
@@ -11,7 +13,10 @@ POLYBAR_NS
 /**
  * Convert string
  */
-const char* logger::convert(string arg) const {  // NOLINT
+const char* logger::convert(string& arg) const {
+  return arg.c_str();
+}
+const char* logger::convert(const string& arg) const {
   return arg.c_str();
 }
 
@@ -32,28 +37,45 @@ logger::make_type logger::make(loglevel level) {
 /**
  * Construct logger
  */
-logger::logger(loglevel level) : m_level(level) {
+logger::logger(loglevel level, int fd) : m_level(level), m_fd(fd), m_slots(new slot[BUFFER_SLOTS]) {
   // clang-format off
   if (isatty(m_fd)) {
-    m_prefixes[loglevel::TRACE]   = "\r\033[0;90m- ";
-    m_prefixes[loglevel::INFO]    = "\r\033[1;32m* \033[0m";
-    m_prefixes[loglevel::WARNING] = "\r\033[1;33mwarn: \033[0m";
-    m_prefixes[loglevel::ERROR]   = "\r\033[1;31merror: \033[0m";
-    m_suffixes[loglevel::TRACE]   = "\033[0m";
-    m_suffixes[loglevel::INFO]    = "\033[0m";
-    m_suffixes[loglevel::WARNING] = "\033[0m";
-    m_suffixes[loglevel::ERROR]   = "\033[0m";
+    m_prefixes[static_cast<size_t>(loglevel::TRACE)]   = "\r\033[0;90m- ";
+    m_prefixes[static_cast<size_t>(loglevel::INFO)]    = "\r\033[1;32m* \033[0m";
+    m_prefixes[static_cast<size_t>(loglevel::WARNING)] = "\r\033[1;33mwarn: \033[0m";
+    m_prefixes[static_cast<size_t>(loglevel::ERROR)]   = "\r\033[1;31merror: \033[0m";
+    m_suffixes[static_cast<size_t>(loglevel::TRACE)]   = "\033[0m";
+    m_suffixes[static_cast<size_t>(loglevel::INFO)]    = "\033[0m";
+    m_suffixes[static_cast<size_t>(loglevel::WARNING)] = "\033[0m";
+    m_suffixes[static_cast<size_t>(loglevel::ERROR)]   = "\033[0m";
   } else {
-    m_prefixes.emplace(make_pair(loglevel::TRACE,   "polybar|trace: "));
-    m_prefixes.emplace(make_pair(loglevel::INFO,    "polybar|info:  "));
-    m_prefixes.emplace(make_pair(loglevel::WARNING, "polybar|warn:  "));
-    m_prefixes.emplace(make_pair(loglevel::ERROR,   "polybar|error: "));
-    m_suffixes.emplace(make_pair(loglevel::TRACE,   ""));
-    m_suffixes.emplace(make_pair(loglevel::INFO,    ""));
-    m_suffixes.emplace(make_pair(loglevel::WARNING, ""));
-    m_suffixes.emplace(make_pair(loglevel::ERROR,   ""));
+    m_prefixes[static_cast<size_t>(loglevel::TRACE)]   = "polybar|trace: ";
+    m_prefixes[static_cast<size_t>(loglevel::INFO)]    = "polybar|info:  ";
+    m_prefixes[static_cast<size_t>(loglevel::WARNING)] = "polybar|warn:  ";
+    m_prefixes[static_cast<size_t>(loglevel::ERROR)]   = "polybar|error: ";
   }
   // clang-format on
+
+  for (size_t i = 0; i < BUFFER_SLOTS; i++) {
+    m_slots[i].seq.store(i, std::memory_order_relaxed);
+  }
+
+  m_thread = std::thread(&logger::flusher, this);
+}
+
+/**
+ * Deconstruct logger, writing all pending messages
+ */
+logger::~logger() {
+  {
+    std::lock_guard<std::mutex> guard(m_waitlock);
+    m_running = false;
+  }
+  m_wakeup.notify_all();
+
+  if (m_thread.joinable()) {
+    m_thread.join();
+  }
 }
 
 /**
@@ -68,6 +90,144 @@ void logger::verbosity(loglevel&& level) {
   m_level = forward<decltype(level)>(level);
 }
 
+/**
+ * Block until the messages logged so far have been written
+ */
+void logger::flush() const {
+  size_t target{m_enqueue_pos.load()};
+  std::unique_lock<std::mutex> guard(m_waitlock);
+
+  while (m_running && m_dequeue_pos.load() < target) {
+    m_wakeup.notify_one();
+    m_drained.wait_for(guard, std::chrono::milliseconds{10});
+  }
+}
+
+/**
+ * Get the number of messages dropped because the buffer was full
+ */
+size_t logger::dropped() const {
+  return m_dropped;
+}
+
+/**
+ * Claim the next free slot of the ring buffer
+ *
+ * Returns nullptr (and counts the message as dropped)
+ * if the writer hasn't caught up yet
+ */
+logger::slot* logger::acquire() const {
+  size_t pos{m_enqueue_pos.load(std::memory_order_relaxed)};
+
+  while (true) {
+    slot* s{&m_slots[pos % BUFFER_SLOTS]};
+    size_t seq{s->seq.load(std::memory_order_acquire)};
+
+    if (seq == pos) {
+      if (m_enqueue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+        return s;
+      }
+    } else if (seq < pos) {
+      m_dropped++;
+      return nullptr;
+    } else {
+      pos = m_enqueue_pos.load(std::memory_order_relaxed);
+    }
+  }
+}
+
+/**
+ * Hand over the formatted slot to the writer
+ */
+void logger::publish(slot* s, loglevel level, int length) const {
+  size_t len{length > 0 ? static_cast<size_t>(length) : 0};
+
+  // Mark truncated messages
+  if (len >= SLOT_SIZE) {
+    len = SLOT_SIZE - 1;
+    memcpy(&s->text[len - 3], "...", 3);
+  }
+
+  s->level = level;
+  s->length = len;
+  s->seq.store(s->seq.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+
+  m_wakeup.notify_one();
+}
+
+/**
+ * Writer thread loop
+ */
+void logger::flusher() {
+  while (true) {
+    if (write_pending()) {
+      continue;
+    }
+
+    std::unique_lock<std::mutex> guard(m_waitlock);
+    m_drained.notify_all();
+
+    if (!m_running) {
+      break;
+    }
+
+    // Producers notify without taking the lock, so a wakeup may be missed
+    // and the wait is bounded to keep the latency low
+    m_wakeup.wait_for(guard, std::chrono::milliseconds{50});
+  }
+}
+
+/**
+ * Write the next message in the buffer
+ *
+ * Returns false if the buffer is empty
+ */
+bool logger::write_pending() {
+  size_t dropped{m_dropped.load()};
+  if (dropped != m_dropped_reported) {
+    char text[64];
+    int len{snprintf(text, sizeof(text), "Dropped %zu log messages", dropped - m_dropped_reported)};
+    write_line(loglevel::WARNING, text, static_cast<size_t>(len));
+    m_dropped_reported = dropped;
+  }
+
+  size_t pos{m_dequeue_pos.load(std::memory_order_relaxed)};
+  slot* s{&m_slots[pos % BUFFER_SLOTS]};
+
+  if (s->seq.load(std::memory_order_acquire) != pos + 1) {
+    return false;
+  }
+
+  write_line(s->level, s->text, s->length);
+
+  s->seq.store(pos + BUFFER_SLOTS, std::memory_order_release);
+  m_dequeue_pos.store(pos + 1, std::memory_order_release);
+
+  return true;
+}
+
+/**
+ * Write a single line using the preformatted level prefix and suffix
+ */
+void logger::write_line(loglevel level, const char* text, size_t length) {
+  const string& prefix{m_prefixes[static_cast<size_t>(level)]};
+  const string& suffix{m_suffixes[static_cast<size_t>(level)]};
+
+  struct iovec iov[4];
+  iov[0].iov_base = const_cast<char*>(prefix.data());
+  iov[0].iov_len = prefix.size();
+  iov[1].iov_base = const_cast<char*>(text);
+  iov[1].iov_len = length;
+  iov[2].iov_base = const_cast<char*>(suffix.data());
+  iov[2].iov_len = suffix.size();
+  iov[3].iov_base = const_cast<char*>("\n");
+  iov[3].iov_len = 1;
+
+  if (writev(m_fd, iov, 4) == -1) {
+    return;
+  }
+}
+
 /**
  * Convert given loglevel name to its enum type counterpart
  */
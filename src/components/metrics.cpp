@@ -0,0 +1,234 @@
+#include <algorithm>
+#include <cstdio>
+
+#include "components/metrics.hpp"
+#include "utils/factory.hpp"
+
+POLYBAR_NS
+
+namespace {
+  constexpr auto relaxed = std::memory_order_relaxed;
+
+  /**
+   * Add the timings of the given metric to the summary
+   */
+  void merge(const metrics::timing& src, metrics::summary& dst) {
+    dst.count += src.count.load(relaxed);
+    dst.sum += src.sum.load(relaxed);
+    dst.max = std::max(dst.max, src.max.load(relaxed));
+    for (size_t i = 0; i < metrics::BUCKETS; i++) {
+      dst.buckets[i] += src.buckets[i].load(relaxed);
+    }
+  }
+
+  /**
+   * Add to a value that is only ever written by the calling thread
+   */
+  void add(std::atomic<uint64_t>& value, uint64_t n) {
+    value.store(value.load(relaxed) + n, relaxed);
+  }
+
+  size_t bucket(uint64_t us) {
+    size_t i{0};
+    while (us > 0 && i < metrics::BUCKETS - 1) {
+      us >>= 1;
+      i++;
+    }
+    return i;
+  }
+}
+
+/**
+ * Get the upper bound (in microseconds) of the bucket
+ * that contains given percentile
+ */
+uint64_t metrics::summary::percentile(double p) const {
+  if (count == 0) {
+    return 0;
+  }
+  auto rank = static_cast<uint64_t>(p / 100.0 * count);
+  uint64_t seen{0};
+  for (size_t i = 0; i < BUCKETS - 1; i++) {
+    if ((seen += buckets[i]) > rank) {
+      return std::min(max, uint64_t{1} << i);
+    }
+  }
+  return max;
+}
+
+/**
+ * Create instance
+ */
+metrics::make_type metrics::make() {
+  return *factory_util::singleton<metrics>();
+}
+
+/**
+ * Construct metrics registry
+ */
+metrics::metrics() : m_origin(clock::now()), m_retired(make_unique<std::array<timing, MAX_METRICS>>()) {}
+
+/**
+ * Register a counter
+ */
+size_t metrics::counter(const string& name) {
+  std::lock_guard<std::mutex> guard(m_mutex);
+  auto it = std::find(m_counter_names.begin(), m_counter_names.end(), name);
+  if (it != m_counter_names.end()) {
+    return it - m_counter_names.begin();
+  } else if (m_counter_names.size() == MAX_METRICS) {
+    return INVALID;
+  }
+  m_counter_names.emplace_back(name);
+  return m_counter_names.size() - 1;
+}
+
+/**
+ * Register a timing histogram
+ */
+size_t metrics::timer(const string& name) {
+  std::lock_guard<std::mutex> guard(m_mutex);
+  auto it = std::find(m_timer_names.begin(), m_timer_names.end(), name);
+  if (it != m_timer_names.end()) {
+    return it - m_timer_names.begin();
+  } else if (m_timer_names.size() == MAX_METRICS) {
+    return INVALID;
+  }
+  m_timer_names.emplace_back(name);
+  return m_timer_names.size() - 1;
+}
+
+/**
+ * Increment counter
+ */
+void metrics::increment(size_t id, uint64_t n) {
+  if (id < MAX_METRICS) {
+    m_counters[id].fetch_add(n, relaxed);
+  }
+}
+
+/**
+ * Add a measurement to the calling thread's histogram
+ */
+void metrics::record(size_t id, clock::duration elapsed) {
+  if (id >= MAX_METRICS) {
+    return;
+  }
+
+  auto elapsed_us = chrono::duration_cast<chrono::microseconds>(elapsed).count();
+  auto us = static_cast<uint64_t>(std::max<decltype(elapsed_us)>(0, elapsed_us));
+  auto& t = local().timings[id];
+
+  add(t.count, 1);
+  add(t.sum, us);
+  add(t.buckets[bucket(us)], 1);
+
+  if (us > t.max.load(relaxed)) {
+    t.max.store(us, relaxed);
+  }
+}
+
+/**
+ * Get current value of counter
+ */
+uint64_t metrics::count(size_t id) const {
+  return id < MAX_METRICS ? m_counters[id].load(relaxed) : 0;
+}
+
+/**
+ * Merge the histograms of all threads for given timer
+ */
+metrics::summary metrics::timings(size_t id) const {
+  summary result{};
+
+  std::lock_guard<std::mutex> guard(m_mutex);
+  if (id < m_timer_names.size()) {
+    result.name = m_timer_names[id];
+    merge((*m_retired)[id], result);
+    for (auto&& s : m_shards) {
+      merge(s->timings[id], result);
+    }
+  }
+
+  return result;
+}
+
+/**
+ * Format all metrics as text
+ */
+string metrics::report() const {
+  std::unique_lock<std::mutex> guard(m_mutex);
+  auto counters = m_counter_names;
+  auto timers = m_timer_names.size();
+  guard.unlock();
+
+  char line[256];
+  string out;
+
+  auto uptime = chrono::duration_cast<chrono::milliseconds>(clock::now() - m_origin).count();
+  snprintf(line, sizeof(line), "Runtime statistics (uptime: %.1f s)\n", uptime / 1000.0);
+  out += line;
+
+  if (!counters.empty()) {
+    out += "\nCounters\n";
+    for (size_t i = 0; i < counters.size(); i++) {
+      snprintf(line, sizeof(line), "  %-40s %12lu\n", counters[i].c_str(), static_cast<unsigned long>(count(i)));
+      out += line;
+    }
+  }
+
+  if (timers > 0) {
+    out += "\nTimings (us)\n";
+    snprintf(line, sizeof(line), "  %-40s %10s %10s %8s %8s %8s %8s\n", "", "count", "mean", "p50", "p90", "p99",
+        "max");
+    out += line;
+    for (size_t i = 0; i < timers; i++) {
+      auto t = timings(i);
+      snprintf(line, sizeof(line), "  %-40s %10lu %10.1f %8lu %8lu %8lu %8lu\n", t.name.c_str(),
+          static_cast<unsigned long>(t.count), t.count ? static_cast<double>(t.sum) / t.count : 0.0,
+          static_cast<unsigned long>(t.percentile(50)), static_cast<unsigned long>(t.percentile(90)),
+          static_cast<unsigned long>(t.percentile(99)), static_cast<unsigned long>(t.max));
+      out += line;
+    }
+  }
+
+  return out;
+}
+
+/**
+ * Get the histograms owned by the calling thread
+ *
+ * The metrics instance has to outlive the threads recording to it
+ */
+metrics::shard& metrics::local() {
+  thread_local auto s = make_unique<shard>(*this);
+  return *s;
+}
+
+/**
+ * Register the histograms of a new thread
+ */
+metrics::shard::shard(metrics& m) : owner(m) {
+  std::lock_guard<std::mutex> guard(owner.m_mutex);
+  owner.m_shards.emplace_back(this);
+}
+
+/**
+ * Fold the histograms of an exiting thread into the retired totals
+ */
+metrics::shard::~shard() {
+  std::lock_guard<std::mutex> guard(owner.m_mutex);
+  owner.m_shards.erase(std::remove(owner.m_shards.begin(), owner.m_shards.end(), this), owner.m_shards.end());
+  for (size_t id = 0; id < MAX_METRICS; id++) {
+    auto& dst = (*owner.m_retired)[id];
+    auto& src = timings[id];
+    dst.count.fetch_add(src.count.load(relaxed), relaxed);
+    dst.sum.fetch_add(src.sum.load(relaxed), relaxed);
+    dst.max.store(std::max(dst.max.load(relaxed), src.max.load(relaxed)), relaxed);
+    for (size_t i = 0; i < BUCKETS; i++) {
+      dst.buckets[i].fetch_add(src.buckets[i].load(relaxed), relaxed);
+    }
+  }
+}
+
+POLYBAR_NS_END
@@ -9,13 +9,17 @@
 #include "utils/factory.hpp"
 #include "utils/file.hpp"
 #include "utils/math.hpp"
-#include "utils/memory.hpp"
 #include "utils/string.hpp"
 
 POLYBAR_NS
 
 using namespace signals::parser;
 
+/**
+ * Number of distinct color strings remembered by the parser
+ */
+static constexpr size_t COLOR_CACHE_SIZE{256};
+
 /**
  * Create instance
  */
@@ -164,6 +168,9 @@ void parser::codeblock(string&& data, const bar_settings& bar) {
 
 /**
  * Process text contents
+ *
+ * The whole span is decoded at once and handed to the
+ * renderer as a single string of code points
  */
 size_t parser::text(string&& data) {
 #ifdef DEBUG_WHITESPACE
@@ -173,71 +180,45 @@ size_t parser::text(string&& data) {
   }
 #endif
 
-  const uint8_t* utf{reinterpret_cast<const uint8_t*>(&data[0])};
+  // An unterminated tag yields an empty span, skip its first character
+  if (data.empty()) {
+    return 1;
+  }
 
-  // clang-format off
-  if (utf[0] < 0x80) {
-    size_t pos{0};
+  m_text.clear();
+  string_util::utf8_to_ucs4(data.data(), data.size(), m_text);
+  m_sig.emit(write_text_string{packet{m_text.data(), m_text.size()}});
 
-    // grab consecutive ascii chars
-    while (utf[pos] && utf[pos] < 0x80) {
-      packet pkt{};
-      size_t limit{memory_util::countof(pkt.data)};
-      size_t len{0};
+  return data.size();
+}
 
-      while (len + 1 < limit && utf[pos] && utf[pos] < 0x80) {
-        pkt.data[len++] = utf[pos++];
-      }
+/**
+ * Process color hex string and convert it to the correct value
+ */
+uint32_t parser::parse_color(const string& s, uint32_t fallback) {
+  if (s.empty() || s[0] == '-') {
+    return fallback;
+  }
 
-      if (!len) {
-        break;
-      }
+  auto it = m_colors.find(s);
 
-      pkt.length = len;
-      m_sig.emit(write_text_string{move(pkt)});
+  if (it == m_colors.end()) {
+    if (m_colors.size() >= COLOR_CACHE_SIZE) {
+      m_colors.clear();
     }
 
-    if (pos > 0) {
-      return pos;
+    parsed_color color{false, 0U, 0U};
+    if ((color.valid = color_util::decode(s.data(), s.size(), color.value))) {
+      color.premultiplied = color_util::premultiply_alpha(color.value);
     }
-
-  } else if ((utf[0] & 0xe0) == 0xc0) {  // 2 byte utf-8 sequence
-    m_sig.emit(write_text_unicode{static_cast<uint16_t>(((utf[0] & 0x1f) << 6) | (utf[1] & 0x3f))});
-    return 2;
-  } else if ((utf[0] & 0xf0) == 0xe0) {  // 3 byte utf-8 sequence
-    m_sig.emit(write_text_unicode{static_cast<uint16_t>(((utf[0] & 0x0f) << 12) | ((utf[1] & 0x3f) << 6) | (utf[2] & 0x3f))});
-    return 3;
-  } else if ((utf[0] & 0xf8) == 0xf0) {  // 4 byte utf-8 sequence
-    // m_sig.emit(write_text_unicode{((utf[0] & 0x07) << 18) | ((utf[1] & 0x3f) << 12) | ((utf[2] & 0x3f) << 6) | (utf[3] & 0x3f)});
-    m_sig.emit(write_text_unicode{static_cast<uint16_t>(0xfffd)});
-    return 4;
-  } else if ((utf[0] & 0xfc) == 0xf8) {  // 5 byte utf-8 sequence
-    // m_sig.emit(write_text_unicode{((utf[0] & 0x03) << 24) | ((utf[1] & 0x3f) << 18) | ((utf[2] & 0x3f) << 12) | ((utf[3] & 0x3f) << 6) | (utf[4] & 0x3f)});
-    m_sig.emit(write_text_unicode{static_cast<uint16_t>(0xfffd)});
-    return 5;
-  } else if ((utf[0] & 0xfe) == 0xfc) {  // 6 byte utf-8 sequence
-    // m_sig.emit(write_text_unicode{((utf[0] & 0x01) << 30) | ((utf[1] & 0x3f) << 24) | ((utf[2] & 0x3f) << 18) | ((utf[3] & 0x3f) << 12) | ((utf[4] & 0x3f) << 6) | (utf[5] & 0x3f)});
-    m_sig.emit(write_text_unicode{static_cast<uint16_t>(0xfffd)});
-    return 6;
-  }
-  // clang-format on
-
-  if (utf[0] < 0x80) {
-    m_sig.emit(write_text_ascii{utf[0]});
+    it = m_colors.emplace(s, color).first;
   }
 
-  return 1;
-}
-
-/**
- * Process color hex string and convert it to the correct value
- */
-uint32_t parser::parse_color(const string& s, uint32_t fallback) {
-  uint32_t color{0};
-  if (s.empty() || s[0] == '-' || (color = color_util::parse(s, fallback)) == fallback) {
+  if (!it->second.valid || it->second.value == fallback) {
     return fallback;
   }
-  return color_util::premultiply_alpha(color);
+
+  return it->second.premultiplied;
 }
 
 /**
@@ -0,0 +1,71 @@
+#include <algorithm>
+#include <unistd.h>
+#include <cstdio>
+
+#include "components/profiler.hpp"
+#include "utils/factory.hpp"
+
+POLYBAR_NS
+
+/**
+ * Create instance
+ */
+profiler::make_type profiler::make() {
+  return *factory_util::singleton<profiler>();
+}
+
+/**
+ * Construct profiler
+ */
+profiler::profiler() : m_origin(clock::now()) {}
+
+/**
+ * Start recording phase timings
+ */
+void profiler::enable() {
+  m_enabled = true;
+}
+
+/**
+ * Check if phase timings are being recorded
+ */
+bool profiler::enabled() const {
+  return m_enabled;
+}
+
+/**
+ * Store the timing of a finished phase
+ */
+void profiler::record(string&& phase, clock::time_point start, clock::time_point end) {
+  if (!m_enabled) {
+    return;
+  }
+  std::lock_guard<std::mutex> guard(m_mutex);
+  m_entries.emplace_back(entry{move(phase), chrono::duration_cast<duration>(start - m_origin),
+      chrono::duration_cast<duration>(end - start)});
+}
+
+/**
+ * Get recorded phases, ordered by their start time
+ */
+vector<profiler::entry> profiler::entries() const {
+  std::unique_lock<std::mutex> guard(m_mutex);
+  vector<entry> result{m_entries};
+  guard.unlock();
+  std::stable_sort(result.begin(), result.end(), [](const entry& a, const entry& b) { return a.offset < b.offset; });
+  return result;
+}
+
+/**
+ * Write the timing breakdown to given fd
+ */
+void profiler::report(int fd) const {
+  auto total = chrono::duration_cast<duration>(clock::now() - m_origin);
+  dprintf(fd, "Startup profile (total: %.3f ms)\n", total.count() / 1000.0);
+  dprintf(fd, "  %10s %10s  %s\n", "start", "elapsed", "phase");
+  for (auto&& e : entries()) {
+    dprintf(fd, "  %7.3f ms %7.3f ms  %s\n", e.offset.count() / 1000.0, e.elapsed.count() / 1000.0, e.phase.c_str());
+  }
+}
+
+POLYBAR_NS_END
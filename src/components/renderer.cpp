@@ -1,5 +1,10 @@
+#include <algorithm>
+
 #include "components/renderer.hpp"
+#include "components/action_index.hpp"
 #include "components/logger.hpp"
+#include "components/metrics.hpp"
+#include "components/profiler.hpp"
 #include "errors.hpp"
 #include "events/signal.hpp"
 #include "events/signal_emitter.hpp"
@@ -15,16 +20,33 @@
 
 POLYBAR_NS
 
+/**
+ * Number of fill contexts kept around before unused ones are released
+ */
+static constexpr size_t FILL_CONTEXTS{32};
+
 /**
  * Create instance
+ *
+ * Renderers configured with the same fonts share
+ * the font manager and its glyph caches
  */
 renderer::make_type renderer::make(const bar_settings& bar, vector<string>&& fonts) {
+  static std::map<vector<string>, std::weak_ptr<font_manager>> font_managers;
+
+  shared_ptr<font_manager> fontmanager{font_managers[fonts].lock()};
+
+  if (!fontmanager) {
+    fontmanager = font_manager::make();
+    font_managers[fonts] = fontmanager;
+  }
+
   // clang-format off
   return factory_util::unique<renderer>(
       connection::make(),
       signal_emitter::make(),
       logger::make(),
-      font_manager::make(),
+      move(fontmanager),
       forward<decltype(bar)>(bar),
       forward<decltype(fonts)>(fonts));
   // clang-format on
@@ -34,7 +56,7 @@ renderer::make_type renderer::make(const bar_settings& bar, vector<string>&& fon
  * Construct renderer instance
  */
 renderer::renderer(connection& conn, signal_emitter& emitter, const logger& logger,
-    unique_ptr<font_manager> font_manager, const bar_settings& bar, const vector<string>& fonts)
+    shared_ptr<font_manager> font_manager, const bar_settings& bar, const vector<string>& fonts)
     : m_connection(conn)
     , m_sig(emitter)
     , m_log(logger)
@@ -87,9 +109,11 @@ renderer::renderer(connection& conn, signal_emitter& emitter, const logger& logg
     // clang-format on
   }
 
-  m_log.trace("renderer: Allocate window pixmap");
+  m_log.trace("renderer: Allocate window pixmaps");
   m_pixmap = m_connection.generate_id();
   m_connection.create_pixmap(m_depth, m_pixmap, m_window, m_rect.width, m_rect.height);
+  m_frontbuffer = m_connection.generate_id();
+  m_connection.create_pixmap(m_depth, m_frontbuffer, m_window, m_rect.width, m_rect.height);
 
   m_log.trace("renderer: Allocate graphic contexts");
   {
@@ -107,6 +131,13 @@ renderer::renderer(connection& conn, signal_emitter& emitter, const logger& logg
     // clang-format on
 
     for (int i = 0; i < 8; i++) {
+      m_colors.emplace(gc(i), colors[i]);
+
+      if (gc(i) == gc::BG || gc(i) == gc::UL || gc(i) == gc::OL) {
+        m_gcontexts.emplace(gc(i), fill_context(colors[i]));
+        continue;
+      }
+
       uint32_t mask{0};
       uint32_t value_list[32]{0};
 
@@ -115,14 +146,18 @@ renderer::renderer(connection& conn, signal_emitter& emitter, const logger& logg
       XCB_AUX_ADD_PARAM(&mask, &params, graphics_exposures, 0);
       connection::pack_values(mask, &params, value_list);
 
-      m_colors.emplace(gc(i), colors[i]);
       m_gcontexts.emplace(gc(i), m_connection.generate_id());
       m_connection.create_gc(m_gcontexts.at(gc(i)), m_pixmap, mask, value_list);
     }
+
+    m_gcforeground = colors[static_cast<int>(gc::FG)];
   }
 
   m_log.trace("renderer: Load fonts");
-  {
+  if (m_fontmanager->loaded()) {
+    m_log.trace("renderer: Using fonts loaded by another bar");
+  } else {
+    profiler::probe probe{profiler::make(), "renderer: load fonts"};
     auto fonts_loaded = false;
     auto fontindex = 0;
 
@@ -153,8 +188,9 @@ renderer::renderer(connection& conn, signal_emitter& emitter, const logger& logg
     if (!fonts_loaded && !m_fontmanager->load("fixed")) {
       throw application_error("Unable to load fonts");
     }
-    m_fontmanager->allocate_color(m_bar.foreground);
   }
+
+  m_fontmanager->allocate_color(m_bar.foreground);
 }
 
 /**
@@ -163,6 +199,16 @@ renderer::renderer(connection& conn, signal_emitter& emitter, const logger& logg
 renderer::~renderer() {
   m_sig.detach(this);
 
+  m_fontmanager->release(m_pixmap);
+  m_fontmanager->release(m_frontbuffer);
+
+  m_connection.free_pixmap(m_pixmap);
+  m_connection.free_pixmap(m_frontbuffer);
+
+  for (auto&& context : m_fillcontexts) {
+    m_connection.free_gc(context.second);
+  }
+
   if (m_window != XCB_NONE) {
     m_connection.destroy_window(m_window);
   }
@@ -186,28 +232,70 @@ void renderer::begin() {
   m_currentx = 0;
   m_attributes = 0;
   m_actions.clear();
+  m_openactions.clear();
+  m_actionshift.clear();
+
+  // Restore the font state if another bar rendered using the shared font manager
+  if (m_fontmanager.use_count() > 1) {
+    m_fontmanager->cleanup();
+    m_fontmanager->fontindex(m_fontindex);
+    m_fontmanager->allocate_color(m_colors[gc::FG]);
+  }
+
+  m_rendering = true;
 }
 
 /**
  * End render routine
  */
 void renderer::end() {
+  static const size_t timer{metrics::make().timer("renderer: end")};
+  metrics::probe probe{metrics::make(), timer};
+
   m_log.trace_x("renderer: end");
 
+  m_rendering = false;
+
   m_fontmanager->cleanup();
 
+  // Apply the shifts that happened after the blocks were closed
+  for (auto&& action : m_actions) {
+    if (!action.active) {
+      action.start_x -= m_actionshift[action.align];
+      action.end_x -= m_actionshift[action.align];
+    }
+  }
+
 #ifdef DEBUG_HINTS
   debug_hints();
 #endif
 
+  std::atomic_store(&m_actionindex, shared_ptr<const action_index>{make_shared<action_index>(move(m_actions))});
+  m_actions.clear();
+
+  // Present the completed frame, the next one is drawn into the other pixmap
+  std::unique_lock<std::mutex> guard(m_flushlock);
+  std::swap(m_pixmap, m_frontbuffer);
+  m_frontrect = m_rect;
+  m_frontarea = m_cleararea;
+  guard.unlock();
+
   flush(false);
 }
 
 /**
- * Flush pixmap contents onto the target window
+ * Flush the last completed frame onto the target window
+ *
+ * Can be called from any thread, e.g. to handle expose events
+ * while the next frame is being drawn
  */
 void renderer::flush(bool clear) {
-  const xcb_rectangle_t& r = m_rect;
+  static const size_t timer{metrics::make().timer("renderer: flush")};
+  metrics::probe probe{metrics::make(), timer};
+
+  std::lock_guard<std::mutex> guard(m_flushlock);
+
+  const xcb_rectangle_t& r = m_frontrect;
 
   xcb_rectangle_t top{0, 0, 0U, 0U};
   top.x += m_bar.borders.at(edge::LEFT).size;
@@ -233,19 +321,19 @@ void renderer::flush(bool clear) {
   // can clear any previous content drawn at the same location
   xcb_rectangle_t clear_area{r.x, r.y, r.width, r.height};
 
-  if (m_cleararea.size && m_cleararea.side == edge::RIGHT) {
+  if (m_frontarea.size && m_frontarea.side == edge::RIGHT) {
     clear_area.x += r.width;
     clear_area.y = top.height;
-    clear_area.width = m_cleararea.size;
-  } else if (m_cleararea.size && m_cleararea.side == edge::LEFT) {
+    clear_area.width = m_frontarea.size;
+  } else if (m_frontarea.size && m_frontarea.side == edge::LEFT) {
     clear_area.x = left.width;
     clear_area.y = top.height;
-    clear_area.width = m_cleararea.size;
-  } else if (m_cleararea.size && m_cleararea.side == edge::TOP) {
-    clear_area.height = m_cleararea.size;
-  } else if (m_cleararea.size && m_cleararea.side == edge::BOTTOM) {
-    clear_area.y += r.height - m_cleararea.size;
-    clear_area.height = m_cleararea.size;
+    clear_area.width = m_frontarea.size;
+  } else if (m_frontarea.size && m_frontarea.side == edge::TOP) {
+    clear_area.height = m_frontarea.size;
+  } else if (m_frontarea.size && m_frontarea.side == edge::BOTTOM) {
+    clear_area.y += r.height - m_frontarea.size;
+    clear_area.height = m_frontarea.size;
   }
 
   if (clear_area != m_cleared && clear_area != 0) {
@@ -264,14 +352,14 @@ void renderer::flush(bool clear) {
     auto y2 = r.y;
     auto w = r.width;
     auto h = r.height - m_bar.shade_size.h + geom->height;
-    m_connection.copy_area(m_pixmap, m_window, m_gcontexts.at(gc::FG), x1, y1, x2, y2, w, h);
+    m_connection.copy_area(m_frontbuffer, m_window, m_gcontexts.at(gc::FG), x1, y1, x2, y2, w, h);
     m_connection.flush();
     return;
   }
 #endif
 
   m_log.trace("renderer: copy pixmap (clear=%i, geom=%dx%d+%d+%d)", clear, r.width, r.height, r.x, r.y);
-  m_connection.copy_area(m_pixmap, m_window, m_gcontexts.at(gc::FG), 0, 0, r.x, r.y, r.width, r.height);
+  m_connection.copy_area(m_frontbuffer, m_window, m_gcontexts.at(gc::FG), 0, 0, r.x, r.y, r.width, r.height);
 
   m_log.trace_x("renderer: draw top border (%lupx, %08x)", top.height, m_bar.borders.at(edge::TOP).color);
   draw_util::fill(m_connection, m_window, m_gcontexts.at(gc::BT), top);
@@ -286,7 +374,7 @@ void renderer::flush(bool clear) {
   draw_util::fill(m_connection, m_window, m_gcontexts.at(gc::BR), right);
 
   if (clear) {
-    m_connection.clear_area(false, m_pixmap, 0, 0, r.width, r.height);
+    m_connection.clear_area(false, m_frontbuffer, 0, 0, r.width, r.height);
   }
 
   m_connection.flush();
@@ -334,6 +422,44 @@ bool renderer::check_attribute(const attribute attr) {
   return (m_attributes >> static_cast<uint8_t>(attr)) & 1U;
 }
 
+/**
+ * Get the graphics context used to fill areas with given color
+ *
+ * Contexts are created once per color and reused, switching colors
+ * does not require any requests once the colors in use are known
+ */
+xcb_gcontext_t renderer::fill_context(uint32_t color) {
+  auto it = m_fillcontexts.find(color);
+
+  if (it != m_fillcontexts.end()) {
+    return it->second;
+  }
+
+  if (m_fillcontexts.size() >= FILL_CONTEXTS) {
+    for (auto context = m_fillcontexts.begin(); context != m_fillcontexts.end();) {
+      if (context->first == m_colors[gc::BG] || context->first == m_colors[gc::UL] ||
+          context->first == m_colors[gc::OL]) {
+        context++;
+      } else {
+        m_connection.free_gc(context->second);
+        context = m_fillcontexts.erase(context);
+      }
+    }
+  }
+
+  uint32_t mask{0};
+  uint32_t value_list[32]{0};
+
+  xcb_params_gc_t params{};
+  XCB_AUX_ADD_PARAM(&mask, &params, foreground, color);
+  XCB_AUX_ADD_PARAM(&mask, &params, graphics_exposures, 0);
+  connection::pack_values(mask, &params, value_list);
+
+  xcb_gcontext_t context{m_connection.generate_id()};
+  m_connection.create_gc(context, m_pixmap, mask, value_list);
+  return m_fillcontexts.emplace(color, context).first->second;
+}
+
 /**
  * Fill background color
  */
@@ -378,29 +504,33 @@ void renderer::fill_shift(const int16_t px) {
 
 /**
  * Draw consecutive character glyphs
+ *
+ * Characters are drawn in runs of glyphs that come from the same font
  */
-void renderer::draw_textstring(const uint16_t* text, size_t len) {
-  m_log.trace_x("renderer: draw_textstring(\"%s\")", text);
+void renderer::draw_textstring(const uint32_t* text, size_t len) {
+  m_log.trace_x("renderer: draw_textstring(%lu)", len);
 
-  for (size_t n = 0; n < len; n++) {
-    vector<uint16_t> chars{text[n]};
-    shared_ptr<font_ref> font{m_fontmanager->match_char(chars[0])};
-    uint8_t width{static_cast<const uint8_t>(m_fontmanager->glyph_width(font, chars[0]) * chars.size())};
+  for (size_t n = 0; n < len;) {
+    shared_ptr<font_ref> font{m_fontmanager->match_char(text[n])};
+    uint8_t width{m_fontmanager->glyph_width(font, text[n])};
 
     if (!font) {
-      m_log.warn("Could not find glyph for %i", chars[0]);
+      m_log.warn("Could not find glyph for %i", text[n++]);
       continue;
     } else if (!width) {
-      m_log.warn("Could not determine glyph width for %i", chars[0]);
+      m_log.warn("Could not determine glyph width for %i", text[n++]);
       continue;
     }
 
-    while (n + 1 < len && text[n + 1] == chars[0]) {
-      chars.emplace_back(text[n++]);
+    const uint32_t* chars{text + n};
+    int16_t run{width};
+
+    while (++n < len && m_fontmanager->match_char(text[n]) == font &&
+           (width = m_fontmanager->glyph_width(font, text[n])) != 0) {
+      run += width;
     }
 
-    width *= chars.size();
-    auto x = shift_content(width);
+    auto x = shift_content(run);
     auto y = m_rect.height / 2 + font->height / 2 - font->descent + font->offset_y;
 
     if (font->ptr != XCB_NONE && m_gcfont != font->ptr) {
@@ -408,19 +538,27 @@ void renderer::draw_textstring(const uint16_t* text, size_t len) {
       m_connection.change_gc(m_gcontexts.at(gc::FG), XCB_GC_FONT, v);
       m_gcfont = font->ptr;
     }
+    if (font->ptr != XCB_NONE && m_gcforeground != m_colors[gc::FG]) {
+      m_connection.change_gc(m_gcontexts.at(gc::FG), XCB_GC_FOREGROUND, &m_colors[gc::FG]);
+      m_gcforeground = m_colors[gc::FG];
+    }
 
-    m_fontmanager->drawtext(font, m_pixmap, m_gcontexts.at(gc::FG), x, y, chars.data(), chars.size());
+    m_fontmanager->drawtext(font, m_pixmap, m_gcontexts.at(gc::FG), x, y, chars, text + n - chars);
 
-    fill_underline(x, width);
-    fill_overline(x, width);
+    fill_underline(x, run);
+    fill_overline(x, run);
   }
 }
 
 /**
- * Get completed action blocks
+ * Get the clickable areas of the last rendered frame
+ *
+ * The index is replaced, never modified, when a new frame completes
+ * so it can be used by other threads without copying it
  */
-const vector<action_block> renderer::get_actions() {
-  return m_actions;
+shared_ptr<const action_index> renderer::get_actions() const {
+  auto index = std::atomic_load(&m_actionindex);
+  return index ? index : make_shared<const action_index>();
 }
 
 /**
@@ -461,16 +599,8 @@ int16_t renderer::shift_content(int16_t x, const int16_t shift_x) {
 
   draw_util::fill(m_connection, m_pixmap, m_gcontexts.at(gc::BG), x, 0, m_rect.width - x, m_rect.height);
 
-  // Translate pos of clickable areas
-  if (m_alignment != alignment::LEFT) {
-    for (auto&& action : m_actions) {
-      if (action.active || action.align != m_alignment) {
-        continue;
-      }
-      action.start_x -= delta;
-      action.end_x -= delta;
-    }
-  }
+  // Translate pos of clickable areas (applied at the end of the frame)
+  m_actionshift[m_alignment] += delta;
 
   m_currentx += shift_x;
 
@@ -533,13 +663,17 @@ void renderer::debug_hints() {
 #endif
 
 bool renderer::on(const change_background& evt) {
+  if (!m_rendering) {
+    return false;
+  }
+
   const uint32_t color{evt.cast()};
 
   if (m_colors[gc::BG] == color) {
     m_log.trace_x("renderer: ignoring unchanged background color(#%08x)", color);
   } else {
     m_log.trace_x("renderer: set_background(#%08x)", color);
-    m_connection.change_gc(m_gcontexts.at(gc::BG), XCB_GC_FOREGROUND, &color);
+    m_gcontexts[gc::BG] = fill_context(color);
     m_colors[gc::BG] = color;
     shift_content(0);
   }
@@ -548,13 +682,16 @@ bool renderer::on(const change_background& evt) {
 }
 
 bool renderer::on(const change_foreground& evt) {
+  if (!m_rendering) {
+    return false;
+  }
+
   const uint32_t color{evt.cast()};
 
   if (m_colors[gc::FG] == color) {
     m_log.trace_x("renderer: ignoring unchanged foreground color(#%08x)", color);
   } else {
     m_log.trace_x("renderer: set_foreground(#%08x)", color);
-    m_connection.change_gc(m_gcontexts.at(gc::FG), XCB_GC_FOREGROUND, &color);
     m_fontmanager->allocate_color(color);
     m_colors[gc::FG] = color;
   }
@@ -563,13 +700,17 @@ bool renderer::on(const change_foreground& evt) {
 }
 
 bool renderer::on(const change_underline& evt) {
+  if (!m_rendering) {
+    return false;
+  }
+
   const uint32_t color{evt.cast()};
 
   if (m_colors[gc::UL] == color) {
     m_log.trace_x("renderer: ignoring unchanged underline color(#%08x)", color);
   } else {
     m_log.trace_x("renderer: set_underline(#%08x)", color);
-    m_connection.change_gc(m_gcontexts.at(gc::UL), XCB_GC_FOREGROUND, &color);
+    m_gcontexts[gc::UL] = fill_context(color);
     m_colors[gc::UL] = color;
   }
 
@@ -577,13 +718,17 @@ bool renderer::on(const change_underline& evt) {
 }
 
 bool renderer::on(const change_overline& evt) {
+  if (!m_rendering) {
+    return false;
+  }
+
   const uint32_t color{evt.cast()};
 
   if (m_colors[gc::OL] == color) {
     m_log.trace_x("renderer: ignoring unchanged overline color(#%08x)", color);
   } else {
     m_log.trace_x("renderer: set_overline(#%08x)", color);
-    m_connection.change_gc(m_gcontexts.at(gc::OL), XCB_GC_FOREGROUND, &color);
+    m_gcontexts[gc::OL] = fill_context(color);
     m_colors[gc::OL] = color;
   }
 
@@ -591,6 +736,10 @@ bool renderer::on(const change_overline& evt) {
 }
 
 bool renderer::on(const change_font& evt) {
+  if (!m_rendering) {
+    return false;
+  }
+
   const uint8_t font{evt.cast()};
 
   if (m_fontindex == font) {
@@ -605,6 +754,10 @@ bool renderer::on(const change_font& evt) {
 }
 
 bool renderer::on(const change_alignment& evt) {
+  if (!m_rendering) {
+    return false;
+  }
+
   auto align = static_cast<const alignment&>(evt.cast());
 
   if (align == m_alignment) {
@@ -619,29 +772,49 @@ bool renderer::on(const change_alignment& evt) {
 }
 
 bool renderer::on(const offset_pixel& evt) {
+  if (!m_rendering) {
+    return false;
+  }
+
   shift_content(evt.cast());
   return true;
 }
 
 bool renderer::on(const attribute_set& evt) {
+  if (!m_rendering) {
+    return false;
+  }
+
   m_log.trace_x("renderer: attribute_set(%i, %i)", static_cast<uint8_t>(evt.cast()), true);
   m_attributes |= 1U << static_cast<uint8_t>(evt.cast());
   return true;
 }
 
 bool renderer::on(const attribute_unset& evt) {
+  if (!m_rendering) {
+    return false;
+  }
+
   m_log.trace_x("renderer: attribute_unset(%i, %i)", static_cast<uint8_t>(evt.cast()), true);
   m_attributes &= ~(1U << static_cast<uint8_t>(evt.cast()));
   return true;
 }
 
 bool renderer::on(const attribute_toggle& evt) {
+  if (!m_rendering) {
+    return false;
+  }
+
   m_log.trace_x("renderer: attribute_toggle(%i)", static_cast<uint8_t>(evt.cast()));
   m_attributes ^= 1U << static_cast<uint8_t>(evt.cast());
   return true;
 }
 
 bool renderer::on(const action_begin& evt) {
+  if (!m_rendering) {
+    return false;
+  }
+
   auto a = static_cast<const action&>(evt.cast());
   action_block action{};
   action.button = a.button;
@@ -655,17 +828,24 @@ bool renderer::on(const action_begin& evt) {
   }
 
   m_log.trace_x("renderer: action_begin(%i, %s)", static_cast<uint8_t>(a.button), a.command.c_str());
+  m_openactions.emplace_back(m_actions.size());
   m_actions.emplace_back(action);
 
   return true;
 }
 
 bool renderer::on(const action_end& evt) {
+  if (!m_rendering) {
+    return false;
+  }
+
   auto btn = static_cast<const mousebtn&>(evt.cast());
   int16_t clickable_width{0};
 
-  for (auto action = m_actions.rbegin(); action != m_actions.rend(); action++) {
-    if (!action->active || action->align != m_alignment || action->button != btn) {
+  for (auto index = m_openactions.rbegin(); index != m_openactions.rend(); index++) {
+    auto action = &m_actions[*index];
+
+    if (action->align != m_alignment || action->button != btn) {
       continue;
     }
 
@@ -688,28 +868,25 @@ bool renderer::on(const action_end& evt) {
         break;
     }
 
-    action->start_x += m_rect.x;
-    action->end_x += m_rect.x;
+    // Offset by the shift so far, only later shifts move the block
+    action->start_x += m_rect.x + m_actionshift[action->align];
+    action->end_x += m_rect.x + m_actionshift[action->align];
 
     m_log.trace_x("renderer: action_end(%i, %s, %i)", static_cast<uint8_t>(btn), action->command, action->width());
   }
 
-  return true;
-}
-
-bool renderer::on(const write_text_ascii& evt) {
-  const uint16_t data[1]{evt.cast()};
-  draw_textstring(data, 1);
-  return true;
-}
+  m_openactions.erase(std::remove_if(m_openactions.begin(), m_openactions.end(),
+                          [&](size_t index) { return !m_actions[index].active; }),
+      m_openactions.end());
 
-bool renderer::on(const write_text_unicode& evt) {
-  const uint16_t data[1]{evt.cast()};
-  draw_textstring(data, 1);
   return true;
 }
 
 bool renderer::on(const write_text_string& evt) {
+  if (!m_rendering) {
+    return false;
+  }
+
   auto pkt = evt.cast();
   draw_textstring(pkt.data, pkt.length);
   return true;
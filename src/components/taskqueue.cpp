@@ -1,5 +1,6 @@
 #include <algorithm>
 
+#include "components/metrics.hpp"
 #include "components/taskqueue.hpp"
 #include "utils/factory.hpp"
 
@@ -64,11 +65,43 @@ void taskqueue::defer_unique(
   m_hold.notify_one();
 }
 
+/**
+ * Run the task on the queue thread as soon as possible, but at most
+ * once per interval
+ *
+ * Calls made while a run is pending are merged into that run. Since the
+ * pending run always starts after the most recent call, the callback
+ * observes the latest state (trailing-edge debounce)
+ */
+void taskqueue::throttle(string id, deferred::duration interval, deferred::callback fn) {
+  std::unique_lock<std::mutex> guard(m_lock);
+
+  for (auto&& task : m_deferred) {
+    if (task->id == id && task->count) {
+      return;
+    }
+  }
+
+  auto now = chrono::time_point_cast<deferred::duration>(deferred::clock::now());
+  auto when = now;
+  auto last = m_throttled.find(id);
+
+  if (last != m_throttled.end() && last->second + interval > now) {
+    when = last->second + interval;
+  }
+
+  m_throttled[id] = when;
+  m_deferred.emplace_back(make_unique<deferred>(move(id), now, when - now, move(fn), 1));
+  guard.unlock();
+  m_hold.notify_one();
+}
+
 void taskqueue::tick() {
   if (!m_lock.try_lock()) {
     return;
   }
   std::unique_lock<std::mutex> guard(m_lock, std::adopt_lock);
+  static const size_t lag{metrics::make().timer("taskqueue: lag")};
   auto now = chrono::time_point_cast<deferred::duration>(deferred::clock::now());
   vector<pair<deferred::callback, size_t>> cbs;
   for (auto it = m_deferred.rbegin(); it != m_deferred.rend(); ++it) {
@@ -76,14 +109,14 @@ void taskqueue::tick() {
     if (task->now + task->wait > now) {
       continue;
     } else if (task->count--) {
+      metrics::make().record(lag, now - (task->now + task->wait));
       cbs.emplace_back(make_pair(task->func, task->count));
       task->now = now;
-    } else {
-      m_deferred.erase(std::remove_if(m_deferred.begin(), m_deferred.end(),
-                           [&](const unique_ptr<deferred>& d) { return d == task; }),
-          m_deferred.end());
     }
   }
+  m_deferred.erase(std::remove_if(m_deferred.begin(), m_deferred.end(),
+                       [](const unique_ptr<deferred>& d) { return d->count == 0; }),
+      m_deferred.end());
   guard.unlock();
   for (auto&& p : cbs) {
     p.first(p.second);
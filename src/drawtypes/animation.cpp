@@ -1,3 +1,5 @@
+#include <algorithm>
+
 #include "drawtypes/animation.hpp"
 #include "drawtypes/label.hpp"
 #include "utils/factory.hpp"
@@ -7,12 +9,21 @@ POLYBAR_NS
 namespace drawtypes {
   void animation::add(icon_t&& frame) {
     m_frames.emplace_back(forward<decltype(frame)>(frame));
-    m_framecount = m_frames.size();
   }
 
   icon_t animation::get() {
-    tick();
-    return m_frames[m_frame];
+    return m_frames[frame_at(clock::now())];
+  }
+
+  /**
+   * Get the index of the frame shown at given time
+   */
+  size_t animation::frame_at(clock::time_point now) const {
+    if (m_frames.empty() || m_framerate_ms <= 0) {
+      return 0;
+    }
+    auto elapsed = chrono::duration_cast<chrono::milliseconds>(now - animation_clock::make().origin());
+    return static_cast<size_t>(elapsed.count() / m_framerate_ms) % m_frames.size();
   }
 
   int animation::framerate() {
@@ -23,18 +34,104 @@ namespace drawtypes {
     return !m_frames.empty();
   }
 
-  void animation::tick() {
-    auto now = chrono::system_clock::now();
-    auto diff = chrono::duration_cast<chrono::milliseconds>(now - m_lastupdate);
+  /**
+   * Create instance
+   */
+  animation_clock::make_type animation_clock::make() {
+    return *factory_util::singleton<animation_clock>();
+  }
+
+  /**
+   * Construct clock
+   */
+  animation_clock::animation_clock() : m_origin(clock::now()) {}
 
-    if (diff.count() < m_framerate_ms) {
-      return;
+  /**
+   * Deconstruct clock and stop the clock thread
+   */
+  animation_clock::~animation_clock() {
+    {
+      std::lock_guard<std::mutex> guard(m_lock);
+      m_stop = true;
     }
-    if (++m_frame >= m_framecount) {
-      m_frame = 0;
+    m_cond.notify_all();
+
+    if (m_thread.joinable()) {
+      m_thread.join();
+    }
+  }
+
+  /**
+   * Get the point in time all animation frames are counted from
+   */
+  animation_clock::clock::time_point animation_clock::origin() const {
+    return m_origin;
+  }
+
+  /**
+   * Call given function each time the frame of the animation changes
+   *
+   * The clock thread is started on the first subscription. The callback
+   * must not subscribe or unsubscribe itself
+   */
+  size_t animation_clock::subscribe(const animation_t& anim, callback&& fn) {
+    std::lock_guard<std::mutex> guard(m_lock);
+
+    auto id = m_nextid++;
+    m_subscribers.emplace_back(subscriber{id, anim, forward<callback>(fn), anim->frame_at(clock::now())});
+
+    if (!m_thread.joinable()) {
+      m_thread = std::thread(&animation_clock::run, this);
     }
 
-    m_lastupdate = now;
+    m_cond.notify_all();
+
+    return id;
+  }
+
+  /**
+   * Remove subscriber, waiting for its callback to return if it is running
+   */
+  void animation_clock::unsubscribe(size_t id) {
+    std::lock_guard<std::mutex> guard(m_lock);
+    m_subscribers.erase(std::remove_if(m_subscribers.begin(), m_subscribers.end(),
+                            [id](const subscriber& s) { return s.id == id; }),
+        m_subscribers.end());
+  }
+
+  /**
+   * Clock thread
+   *
+   * Sleeps until the next frame boundary of any subscribed animation,
+   * using absolute deadlines so that the wakeups do not accumulate drift
+   */
+  void animation_clock::run() {
+    std::unique_lock<std::mutex> guard(m_lock);
+
+    while (!m_stop) {
+      auto now = clock::now();
+      auto elapsed = chrono::duration_cast<chrono::milliseconds>(now - m_origin);
+      auto wakeup = clock::time_point::max();
+
+      for (auto&& s : m_subscribers) {
+        auto frame = s.anim->frame_at(now);
+        if (frame != s.frame) {
+          s.frame = frame;
+          s.fn();
+        }
+
+        chrono::milliseconds framerate{s.anim->framerate()};
+        if (framerate.count() > 0) {
+          wakeup = std::min(wakeup, m_origin + (elapsed / framerate + 1) * framerate);
+        }
+      }
+
+      if (wakeup == clock::time_point::max()) {
+        m_cond.wait(guard);
+      } else {
+        m_cond.wait_until(guard, wakeup);
+      }
+    }
   }
 
   /**
@@ -131,22 +131,32 @@ namespace drawtypes {
    * Create a label by loading values from the configuration
    */
   label_t load_label(const config& conf, const string& section, string name, bool required, string def) {
-    vector<token> tokens;
-    size_t start, end, pos;
-
     name = string_util::ltrim(string_util::rtrim(move(name), '>'), '<');
 
     string text;
 
-    struct side_values padding {
-    }, margin{};
-
     if (required) {
       text = conf.get(section, name);
     } else {
       text = conf.get(section, name, move(def));
     }
 
+    return make_label(conf, section, move(name), move(text));
+  }
+
+  /**
+   * Create a label with given text, loading the
+   * remaining values from the configuration
+   */
+  label_t make_label(const config& conf, const string& section, string name, string text) {
+    vector<token> tokens;
+    size_t start, end, pos;
+
+    name = string_util::ltrim(string_util::rtrim(move(name), '>'), '<');
+
+    struct side_values padding {
+    }, margin{};
+
     size_t len{text.size()};
 
     if (len > 2 && text[0] == '"' && text[len - 1] == '"') {
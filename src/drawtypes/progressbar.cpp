@@ -13,14 +13,17 @@ namespace drawtypes {
       : m_builder(factory_util::unique<builder>(bar)), m_format(move(format)), m_width(width) {}
 
   void progressbar::set_fill(icon_t&& fill) {
+    m_cache.clear();
     m_fill = forward<decltype(fill)>(fill);
   }
 
   void progressbar::set_empty(icon_t&& empty) {
+    m_cache.clear();
     m_empty = forward<decltype(empty)>(empty);
   }
 
   void progressbar::set_indicator(icon_t&& indicator) {
+    m_cache.clear();
     if (!m_indicator && indicator.get()) {
       m_width--;
     }
@@ -28,10 +31,12 @@ namespace drawtypes {
   }
 
   void progressbar::set_gradient(bool mode) {
+    m_cache.clear();
     m_gradient = mode;
   }
 
   void progressbar::set_colors(vector<string>&& colors) {
+    m_cache.clear();
     m_colors = forward<decltype(colors)>(colors);
 
     if (m_colors.empty()) {
@@ -42,15 +47,31 @@ namespace drawtypes {
   }
 
   string progressbar::output(float percentage) {
-    string output{m_format};
-
-    // Get fill/empty widths based on percentage
+    // Get fill width and color based on percentage
     unsigned int perc = math_util::cap(percentage, 0.0f, 100.0f);
     unsigned int fill_width = math_util::percentage_to_value(perc, m_width);
+    size_t color{0};
+
+    if (!m_colors.empty() && !m_gradient) {
+      color = math_util::percentage_to_value<size_t>(perc, m_colors.size() - 1);
+    }
+
+    auto key = fill_width * (m_colors.size() + 1) + color;
+    auto cached = m_cache.find(key);
+
+    if (cached == m_cache.end()) {
+      cached = m_cache.emplace(key, render(fill_width, color)).first;
+    }
+
+    return cached->second;
+  }
+
+  string progressbar::render(unsigned int fill_width, size_t color) {
+    string output{m_format};
     unsigned int empty_width = m_width - fill_width;
 
     // Output fill icons
-    fill(perc, fill_width);
+    fill(fill_width, color);
     output = string_util::replace_all(output, "%fill%", m_builder->flush());
 
     // Output indicator icon
@@ -64,11 +85,10 @@ namespace drawtypes {
     return output;
   }
 
-  void progressbar::fill(unsigned int perc, unsigned int fill_width) {
+  void progressbar::fill(unsigned int fill_width, size_t color) {
     if (m_colors.empty()) {
       m_builder->node_repeat(m_fill, fill_width);
     } else if (m_gradient) {
-      size_t color = 0;
       for (size_t i = 0; i < fill_width; i++) {
         if (i % m_colorstep == 0 && color < m_colors.size()) {
           m_fill->m_foreground = m_colors[color++];
@@ -76,7 +96,6 @@ namespace drawtypes {
         m_builder->node(m_fill);
       }
     } else {
-      size_t color = math_util::percentage_to_value<size_t>(perc, m_colors.size() - 1);
       m_fill->m_foreground = m_colors[color];
       m_builder->node_repeat(m_fill, fill_width);
     }
@@ -1,7 +1,10 @@
-#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
 #include <algorithm>
 #include <cstdlib>
 #include <cstring>
+#include <iostream>
 #include <vector>
 
 #include "common.hpp"
@@ -15,6 +18,16 @@ using namespace std;
 #define IPC_CHANNEL_PREFIX "/tmp/polybar_mqueue."
 #endif
 
+// Time to wait for a reply, in seconds
+#define IPC_REPLY_TIMEOUT 2
+
+const int E_NO_CHANNELS{2};
+const int E_MESSAGE_TYPE{3};
+const int E_INVALID_PID{4};
+const int E_INVALID_CHANNEL{5};
+const int E_WRITE{6};
+const int E_REJECTED{7};
+
 void log(const string& msg) {
   fprintf(stderr, "polybar-msg: %s\n", msg.c_str());
 }
@@ -31,7 +44,7 @@ void usage(const string& parameters) {
 
 void remove_pipe(const string& handle) {
   if (unlink(handle.c_str()) == -1) {
-    log(1, "Could not remove stale ipc channel: "s + strerror(errno));
+    log("Could not remove stale ipc channel \"" + handle + "\": " + strerror(errno));
   } else {
     log("Removed stale ipc channel: " + handle);
   }
@@ -44,24 +57,99 @@ bool validate_type(const string& type) {
     return true;
   } else if (type == "hook") {
     return true;
+  } else if (type == "stats") {
+    return true;
+  } else if (type == "subscribe") {
+    return true;
+  } else if (type == "batch") {
+    return true;
   } else {
     return false;
   }
 }
 
-int main(int argc, char** argv) {
-  const int E_NO_CHANNELS{2};
-  const int E_MESSAGE_TYPE{3};
-  const int E_INVALID_PID{4};
-  const int E_INVALID_CHANNEL{5};
-  const int E_WRITE{6};
+/**
+ * Connect to the ipc socket at given path
+ *
+ * Returns -1 and sets errno if the connection failed,
+ * ECONNREFUSED means nobody is listening on the socket
+ */
+int connect_channel(const string& path) {
+  struct sockaddr_un addr {};
+  addr.sun_family = AF_UNIX;
+
+  if (path.size() >= sizeof(addr.sun_path)) {
+    errno = ENAMETOOLONG;
+    return -1;
+  }
+
+  path.copy(addr.sun_path, path.size());
+
+  int fd{socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0)};
+
+  if (fd != -1 && connect(fd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) == -1) {
+    int err{errno};
+    close(fd);
+    errno = err;
+    fd = -1;
+  }
+
+  return fd;
+}
+
+/**
+ * Receive a single packet, regardless of its size
+ */
+bool receive_packet(int fd, string& packet) {
+  ssize_t bytes{recv(fd, nullptr, 0, MSG_PEEK | MSG_TRUNC)};
+
+  if (bytes <= 0) {
+    return false;
+  }
+
+  packet.resize(bytes);
+
+  return recv(fd, &packet[0], packet.size(), 0) == bytes;
+}
+
+/**
+ * Print the reply to a request
+ *
+ * Failed requests are reported on stderr and data sent
+ * along with the reply is written to stdout
+ *
+ * Returns false if any of the requests was rejected
+ */
+bool print_reply(const string& channel, const string& reply) {
+  auto data = reply.find("\n\n");
+  auto status = reply.substr(0, data);
+  bool success{true};
+
+  for (size_t pos = 0, end; pos < status.size(); pos = end + 1) {
+    if ((end = status.find('\n', pos)) == string::npos) {
+      end = status.size();
+    }
+    auto line = status.substr(pos, end - pos);
+    if (!line.empty() && line.compare(0, 2, "0 ") != 0) {
+      log("\"" + channel + "\" replied: " + line);
+      success = false;
+    }
+  }
+
+  if (data != string::npos) {
+    fwrite(reply.data() + data + 2, 1, reply.size() - data - 2, stdout);
+  }
+
+  return success;
+}
 
+int main(int argc, char** argv) {
   vector<string> args{argv + 1, argv + argc};
   string::size_type p;
   int pid{0};
 
   // If -p <pid> is passed, check if the process is running and that
-  // a valid channel pipe is available
+  // a valid channel socket is available
   if (args.size() >= 2 && args[0].compare(0, 2, "-p") == 0) {
     if (!file_util::exists("/proc/" + args[1])) {
       log(E_INVALID_PID, "No process with pid " + args[1]);
@@ -76,67 +164,122 @@ int main(int argc, char** argv) {
 
   // Validate args
   auto help = find_if(args.begin(), args.end(), [](string a) { return a == "-h" || a == "--help"; }) != args.end();
-  if (help || args.size() < 2) {
-    usage("<command=(action|cmd|hook)> <payload> [...]");
+  bool standalone{!args.empty() && (args[0] == "stats" || args[0] == "subscribe" || args[0] == "batch")};
+
+  if (help || args.empty() || (args.size() < 2 && !standalone)) {
+    usage("<command=(action|cmd|hook)> <payload> [...] | stats | subscribe | batch");
   } else if (!validate_type(args[0])) {
     log(E_MESSAGE_TYPE, "\"" + args[0] + "\" is not a valid type.");
   }
 
   string ipc_type{args[0]};
   args.erase(args.begin());
-  string ipc_payload{args[0]};
-  args.erase(args.begin());
+  string payload;
 
-  // Check hook specific args
-  if (ipc_type == "hook") {
-    if (args.size() != 1) {
-      usage("hook <module-name> <hook-index>");
-    } else if ((p = ipc_payload.find("module/")) != 0) {
-      ipc_payload = "module/" + ipc_payload + args[0];
-      args.erase(args.begin());
-    } else {
-      ipc_payload += args[0];
-      args.erase(args.begin());
+  if (ipc_type == "stats" || ipc_type == "subscribe") {
+    payload = ipc_type;
+  } else if (ipc_type == "batch") {
+    // Read one request per line from stdin, sent as a single message
+    for (string line; getline(cin, line);) {
+      payload += line + '\n';
     }
+  } else {
+    string ipc_payload{args[0]};
+    args.erase(args.begin());
+
+    // Check hook specific args
+    if (ipc_type == "hook") {
+      if (args.size() != 1) {
+        usage("hook <module-name> <hook-index>");
+      } else if ((p = ipc_payload.find("module/")) != 0) {
+        ipc_payload = "module/" + ipc_payload + args[0];
+        args.erase(args.begin());
+      } else {
+        ipc_payload += args[0];
+        args.erase(args.begin());
+      }
+    }
+
+    payload = ipc_type + ':' + ipc_payload;
   }
 
-  // Get availble channel pipes
-  auto pipes = file_util::glob(IPC_CHANNEL_PREFIX + "*"s);
+  // Get availble channel sockets
+  auto channels = file_util::glob(IPC_CHANNEL_PREFIX + "*"s);
 
   // Remove stale channel files without a running parent process
-  for (auto it = pipes.rbegin(); it != pipes.rend(); it++) {
+  for (auto it = channels.rbegin(); it != channels.rend(); it++) {
     if ((p = it->rfind('.')) == string::npos) {
       continue;
     } else if (!file_util::exists("/proc/" + it->substr(p + 1))) {
       remove_pipe(*it);
-      pipes.erase(remove(pipes.begin(), pipes.end(), *it), pipes.end());
+      channels.erase(remove(channels.begin(), channels.end(), *it), channels.end());
     } else if (pid && to_string(pid) != it->substr(p + 1)) {
-      pipes.erase(remove(pipes.begin(), pipes.end(), *it), pipes.end());
+      channels.erase(remove(channels.begin(), channels.end(), *it), channels.end());
     }
   }
 
-  if (pipes.empty()) {
+  if (channels.empty()) {
     log(E_NO_CHANNELS, "No active ipc channels");
+  } else if (ipc_type == "subscribe" && channels.size() > 1) {
+    log(E_INVALID_CHANNEL, "Multiple ipc channels available, select one using -p");
   }
 
-  int exit_status = 127;
+  bool sent{false};
+  bool rejected{false};
 
-  // Write message to each available channel or match
+  // Send message to each available channel or match
   // against pid if one was defined
-  for (auto&& channel : pipes) {
-    try {
-      file_descriptor fd(channel, O_WRONLY | O_NONBLOCK);
-      string payload{ipc_type + ':' + ipc_payload};
-      if (write(fd, payload.c_str(), payload.size()) != -1) {
-        log("Successfully wrote \"" + payload + "\" to \"" + channel + "\"");
-        exit_status = 0;
-      } else {
-        log(E_WRITE, "Failed to write \"" + payload + "\" to \"" + channel + "\" (err: " + strerror(errno) + ")");
-      }
-    } catch (const exception& err) {
+  for (auto&& channel : channels) {
+    int fd{connect_channel(channel)};
+
+    // Only a refused connection means the socket is stale, other errors
+    // (e.g. the socket of another user) must not stop the remaining bars
+    if (fd == -1 && errno == ECONNREFUSED) {
       remove_pipe(channel);
+      continue;
+    } else if (fd == -1) {
+      log("Failed to connect to \"" + channel + "\" (err: " + strerror(errno) + ")");
+      continue;
+    }
+
+    file_descriptor sock{fd};
+    struct timeval timeout {};
+    timeout.tv_sec = IPC_REPLY_TIMEOUT;
+    setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+    string reply;
+
+    if (send(sock, payload.c_str(), payload.size(), MSG_NOSIGNAL) == -1) {
+      log(E_WRITE, "Failed to write \"" + payload + "\" to \"" + channel + "\" (err: " + strerror(errno) + ")");
+    } else if (!receive_packet(sock, reply)) {
+      log(E_WRITE, "No reply from \"" + channel + "\" (err: " + strerror(errno) + ")");
+    }
+
+    if (ipc_type == "stats" && channels.size() > 1) {
+      printf("%s:\n", channel.c_str());
     }
+
+    sent = true;
+
+    if (!print_reply(channel, reply)) {
+      rejected = true;
+    } else if (ipc_type != "subscribe") {
+      log("Successfully wrote \"" + payload + "\" to \"" + channel + "\"");
+    } else {
+      // Print events until the bar goes away
+      timeout.tv_sec = 0;
+      setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+      for (string event; receive_packet(sock, event);) {
+        printf("%s\n", event.c_str());
+        fflush(stdout);
+      }
+    }
+  }
+
+  if (rejected) {
+    return E_REJECTED;
   }
 
-  return exit_status;
+  return sent ? 0 : 127;
 }
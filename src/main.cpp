@@ -6,6 +6,7 @@
 #include "components/ipc.hpp"
 #include "components/logger.hpp"
 #include "components/parser.hpp"
+#include "components/profiler.hpp"
 #include "components/renderer.hpp"
 #include "settings.hpp"
 #include "utils/env.hpp"
@@ -31,6 +32,7 @@ int main(int argc, char** argv) {
       command_line::option{"-m", "--list-monitors", "Print list of available monitors and exit"},
       command_line::option{"-w", "--print-wmname", "Print the generated WM_NAME and exit"},
       command_line::option{"-s", "--stdout", "Output data to stdout instead of drawing the X window"},
+      command_line::option{"-p", "--profile-startup", "Print a timing breakdown of the startup phases"},
   };
   // clang-format on
 
@@ -38,6 +40,7 @@ int main(int argc, char** argv) {
   bool reload{false};
 
   logger& logger{const_cast<decltype(logger)>(logger::make(loglevel::WARNING))};
+  profiler& prof{profiler::make()};
 
   try {
     //==================================================
@@ -63,9 +66,14 @@ int main(int argc, char** argv) {
       return EXIT_SUCCESS;
     }
 
+    if (cli->has("profile-startup")) {
+      prof.enable();
+    }
+
     //==================================================
     // Connect to X server
     //==================================================
+    auto connect_probe = make_unique<profiler::probe>(prof, "x11: connect");
     XInitThreads();
     Display* xdisplay{XOpenDisplay(nullptr)};
 
@@ -76,6 +84,7 @@ int main(int argc, char** argv) {
 
     connection& conn{connection::make(xdisplay)};
     conn.ensure_event_mask(conn.root(), XCB_EVENT_MASK_PROPERTY_CHANGE);
+    connect_probe.reset();
 
     //==================================================
     // List available XRandR entries
@@ -102,6 +111,13 @@ int main(int argc, char** argv) {
       return EXIT_FAILURE;
     }
 
+    // All bars passed in are hosted by this process,
+    // the configuration is loaded for the first one
+    vector<string> bars;
+    for (size_t i = 0; cli->has(i); i++) {
+      bars.emplace_back(cli->get(i));
+    }
+
     if (cli->has("config")) {
       confpath = cli->get("config");
     } else if (env_util::has("XDG_CONFIG_HOME")) {
@@ -112,7 +128,9 @@ int main(int argc, char** argv) {
       throw application_error("Define configuration using --config=PATH");
     }
 
-    config::make_type conf{config::make(move(confpath), cli->get(0))};
+    config::make_type conf{prof.measure("config: parse", [&]() -> config::make_type {
+      return config::make(move(confpath), cli->get(0));
+    })};
 
     //==================================================
     // Dump requested data
@@ -122,7 +140,7 @@ int main(int argc, char** argv) {
       return EXIT_SUCCESS;
     }
     if (cli->has("print-wmname")) {
-      printf("%s\n", bar::make(true)->settings().wmname.c_str());
+      printf("%s\n", bar::make(cli->get(0), true)->settings()->wmname.c_str());
       return EXIT_SUCCESS;
     }
 
@@ -139,7 +157,8 @@ int main(int argc, char** argv) {
       config_watch = inotify_util::make_watch(conf.filepath());
     }
 
-    auto ctrl = controller::make(move(ipc), move(config_watch));
+    auto ctrl = prof.measure(
+        "controller: create", [&] { return controller::make(bars, move(ipc), move(config_watch)); });
 
     if (!ctrl->run(cli->has("stdout"))) {
       reload = true;
@@ -156,6 +175,7 @@ int main(int argc, char** argv) {
 
   if (reload) {
     logger.info("Re-launching application...");
+    logger.flush();
     process_util::exec(move(argv[0]), move(argv));
   }
 
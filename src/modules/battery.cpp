@@ -126,20 +126,28 @@ namespace modules {
   }
 
   /**
-   * Dispatch the subthread used to update the
+   * Subscribe to the animation clock to update the
    * charging animation when the module is started
    */
   void battery_module::start() {
     this->inotify_module::start();
-    m_subthread = thread(&battery_module::subthread, this);
+
+    if (m_animation_charging) {
+      m_animation_subscription = animation_clock::make().subscribe(m_animation_charging, [this] {
+        if (running() && m_state == battery_module::state::CHARGING) {
+          broadcast();
+        }
+      });
+    }
   }
 
   /**
    * Release wake lock when stopping the module
    */
   void battery_module::teardown() {
-    if (m_subthread.joinable()) {
-      m_subthread.join();
+    if (m_animation_subscription) {
+      animation_clock::make().unsubscribe(m_animation_subscription);
+      m_animation_subscription = 0;
     }
   }
 
@@ -291,31 +299,6 @@ namespace modules {
     strftime(buffer, sizeof(buffer), m_timeformat.c_str(), &t);
     return {buffer};
   }
-
-  /**
-   * Subthread runner that emit update events
-   * to refresh <animation-charging> in case it is used.
-   */
-  void battery_module::subthread() {
-    chrono::duration<double> dur{0.0};
-
-    if (m_animation_charging) {
-      dur += chrono::milliseconds{m_animation_charging->framerate()};
-    } else {
-      dur += 1s;
-    }
-
-    while (running()) {
-      for (int i = 0; running() && i < dur.count(); ++i) {
-        if (m_state == battery_module::state::CHARGING) {
-          broadcast();
-        }
-        sleep(dur);
-      }
-    }
-
-    m_log.trace("%s: End of subthread", name());
-  }
 }
 
 POLYBAR_NS_END
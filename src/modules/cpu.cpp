@@ -34,7 +34,7 @@ namespace modules {
       m_rampload_core = load_ramp(m_conf, name(), TAG_RAMP_LOAD_PER_CORE);
     }
     if (m_formatter->has(TAG_LABEL)) {
-      // Update the label parameter and replace the %percentag-cores% token with the individual core tokens
+      // Replace the %percentage-cores% token with the individual core tokens
       string key{&TAG_LABEL[1], strlen(TAG_LABEL) - 2};
       auto label = m_conf.get<string>(name(), key, "%percentage%%");
       vector<string> cores;
@@ -42,9 +42,8 @@ namespace modules {
         cores.emplace_back("%percentage-core" + to_string(i) + "%%");
       }
       label = string_util::replace_all(label, "%percentage-cores%", string_util::join(cores, " "));
-      const_cast<config&>(m_conf).set(name(), key, move(label));
 
-      m_label = load_optional_label(m_conf, name(), TAG_LABEL, "%percentage%%");
+      m_label = make_label(m_conf, name(), TAG_LABEL, move(label));
     }
   }
 
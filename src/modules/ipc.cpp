@@ -102,14 +102,19 @@ namespace modules {
    * Map received message hook to the ones
    * configured from the user config and
    * execute its command
+   *
+   * Returns false if no hook matched the message
    */
-  void ipc_module::on_message(const string& message) {
+  bool ipc_module::on_message(const string& message) {
+    bool matched{false};
+
     for (auto&& hook : m_hooks) {
       if (hook->payload != message) {
         continue;
       }
 
       m_log.info("%s: Found matching hook (%s)", name(), hook->payload);
+      matched = true;
 
       try {
         auto command = command_util::make_command(hook->command);
@@ -122,6 +127,8 @@ namespace modules {
 
       broadcast();
     }
+
+    return matched;
   }
 }
 
@@ -65,14 +65,26 @@ namespace modules {
     } else {
       m_wired = factory_util::unique<net::wired_network>(m_interface);
     };
+  }
+
+  void network_module::start() {
+    this->timer_module::start();
 
-    // We only need to start the subthread if the packetloss animation is used
+    // The animation clock only needs to refresh the output if the packetloss animation is used
     if (m_animation_packetloss) {
-      m_threads.emplace_back(thread(&network_module::subthread_routine, this));
+      m_animation_subscription = animation_clock::make().subscribe(m_animation_packetloss, [this] {
+        if (running() && m_connected && m_packetloss) {
+          broadcast();
+        }
+      });
     }
   }
 
   void network_module::teardown() {
+    if (m_animation_subscription) {
+      animation_clock::make().unsubscribe(m_animation_subscription);
+      m_animation_subscription = 0;
+    }
     m_wireless.reset();
     m_wired.reset();
   }
@@ -163,20 +175,6 @@ namespace modules {
     }
     return true;
   }
-
-  void network_module::subthread_routine() {
-    const chrono::milliseconds framerate{m_animation_packetloss->framerate()};
-    const auto dur = chrono::duration<double>(framerate);
-
-    while (running()) {
-      if (m_connected && m_packetloss) {
-        broadcast();
-      }
-      sleep(dur);
-    }
-
-    m_log.trace("%s: Reached end of network subthread", name());
-  }
 }
 
 POLYBAR_NS_END
@@ -1,5 +1,8 @@
 #include <cstring>
 #include <iomanip>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 #include <sstream>
 #include <utility>
 
@@ -231,6 +234,84 @@ namespace string_util {
   hash_type hash(const string& src) {
     return std::hash<string>()(src);
   }
+
+  /**
+   * Decode UTF-8 text and append the code points to result
+   *
+   * Malformed, overlong and surrogate sequences as well as values
+   * beyond U+10FFFF are replaced with U+FFFD. Runs of ASCII are
+   * widened 16 bytes at a time where SSE2 is available
+   *
+   * Returns false if any sequence had to be replaced
+   */
+  bool utf8_to_ucs4(const char* src, size_t len, vector<uint32_t>& result) {
+    const uint8_t* utf{reinterpret_cast<const uint8_t*>(src)};
+    size_t offset{result.size()};
+    bool valid{true};
+
+    // Each byte produces at most one code point
+    result.resize(offset + len);
+    uint32_t* out{result.data() + offset};
+
+    for (size_t pos = 0; pos < len;) {
+#if defined(__SSE2__)
+      const __m128i zero{_mm_setzero_si128()};
+      while (len - pos >= 16) {
+        const __m128i bytes{_mm_loadu_si128(reinterpret_cast<const __m128i*>(utf + pos))};
+        if (_mm_movemask_epi8(bytes) != 0) {
+          break;
+        }
+        const __m128i lo{_mm_unpacklo_epi8(bytes, zero)};
+        const __m128i hi{_mm_unpackhi_epi8(bytes, zero)};
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out), _mm_unpacklo_epi16(lo, zero));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 4), _mm_unpackhi_epi16(lo, zero));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 8), _mm_unpacklo_epi16(hi, zero));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 12), _mm_unpackhi_epi16(hi, zero));
+        out += 16;
+        pos += 16;
+      }
+      if (pos == len) {
+        break;
+      }
+#endif
+
+      const uint8_t lead{utf[pos]};
+
+      if (lead < 0x80) {
+        *out++ = lead;
+        pos++;
+        continue;
+      }
+
+      size_t length{0};
+      uint32_t cp{0};
+      uint32_t min{0};
+
+      if ((lead & 0xe0) == 0xc0) {
+        length = 2, cp = lead & 0x1f, min = 0x80;
+      } else if ((lead & 0xf0) == 0xe0) {
+        length = 3, cp = lead & 0x0f, min = 0x800;
+      } else if ((lead & 0xf8) == 0xf0) {
+        length = 4, cp = lead & 0x07, min = 0x10000;
+      }
+
+      size_t read{1};
+      while (read < length && pos + read < len && (utf[pos + read] & 0xc0) == 0x80) {
+        cp = cp << 6 | (utf[pos + read++] & 0x3f);
+      }
+
+      if (read < length || length == 0 || cp < min || cp > 0x10ffff || (cp >= 0xd800 && cp <= 0xdfff)) {
+        cp = 0xfffd;
+        valid = false;
+      }
+
+      *out++ = cp;
+      pos += read;
+    }
+
+    result.resize(out - result.data());
+    return valid;
+  }
 }
 
 POLYBAR_NS_END
@@ -18,9 +18,22 @@ connection::make_type connection::make(Display* display) {
       *factory_util::singleton<std::remove_reference_t<connection::make_type>>(display));
 }
 
-connection::connection(Display* dsp) : base_type(XGetXCBConnection(dsp)), m_display(dsp) {
+/**
+ * Construct connection using the xcb connection of given display
+ */
+connection::connection(Display* dsp) : connection(XGetXCBConnection(dsp)) {
+  m_display = dsp;
   XSetEventQueueOwner(m_display, XCBOwnsEventQueue);
+}
 
+/**
+ * Construct connection without an Xlib display
+ *
+ * The connection is closed when the instance is destroyed. This allows
+ * connecting to other request sinks than the X server, such as the fake
+ * server used by the tests, which records the issued requests
+ */
+connection::connection(xcb_connection_t* conn) : base_type(conn) {
   // Preload required xcb atoms {{{
 
   vector<xcb_intern_atom_cookie_t> cookies(memory_util::countof(ATOMS));
@@ -1,3 +1,6 @@
+#include <algorithm>
+#include <cstring>
+
 #include "x11/fonts.hpp"
 #include "components/logger.hpp"
 #include "errors.hpp"
@@ -9,12 +12,22 @@
 
 POLYBAR_NS
 
+/**
+ * Number of pens/colors kept allocated before the pools are released
+ */
+static constexpr size_t COLOR_POOL_SIZE{64};
+
 void font_ref::_deleter::operator()(font_ref* font) {
   font->glyph_widths.clear();
   font->width_lut.clear();
 
   if (font->xft != nullptr || font->ptr != XCB_NONE) {
     auto& conn = connection::make();
+#if WITH_XRENDER
+    if (font->glyphset != XCB_NONE) {
+      xcb_render_free_glyph_set(conn, font->glyphset);
+    }
+#endif
     if (font->xft != nullptr) {
       XftFontClose(conn, font->xft);
     }
@@ -37,13 +50,29 @@ font_manager::font_manager(connection& conn, const logger& logger)
     , m_logger(logger)
     , m_display(m_connection)
     , m_visual(m_connection.visual())
-    , m_colormap(XDefaultColormap(m_display, m_connection.default_screen())) {}
+    , m_colormap(XDefaultColormap(m_display, m_connection.default_screen())) {
+#if WITH_XRENDER
+  if ((m_xrender = init_xrender())) {
+    m_logger.trace("font_manager: Drawing Xft fonts using XRender glyph sets");
+  } else {
+    m_logger.warn("No XRender picture format found for the visual, drawing text using Xft");
+  }
+#endif
+}
 
 font_manager::~font_manager() {
   cleanup();
+#if WITH_XRENDER
+  for (auto&& picture : m_pictures) {
+    xcb_render_free_picture(m_connection, picture.second);
+  }
+  for (auto&& pen : m_pens) {
+    xcb_render_free_picture(m_connection, pen.second);
+  }
+#endif
   if (m_display) {
-    if (m_xftcolor_allocated) {
-      XftColorFree(m_display, m_visual, m_colormap, &m_xftcolor);
+    for (auto&& color : m_xftcolors) {
+      XftColorFree(m_display, m_visual, m_colormap, &color.second);
     }
     XFreeColormap(m_display, m_colormap);
   }
@@ -51,6 +80,9 @@ font_manager::~font_manager() {
 
 void font_manager::set_visual(Visual* v) {
   m_visual = v;
+#if WITH_XRENDER
+  m_xrender = init_xrender();
+#endif
 }
 
 void font_manager::cleanup() {
@@ -60,6 +92,29 @@ void font_manager::cleanup() {
   }
 }
 
+/**
+ * Drop the resources bound to given pixmap before it is freed
+ *
+ * The font manager is shared between renderers and outlives them, so
+ * anything cached per pixmap has to be released by its owner
+ */
+void font_manager::release(xcb_pixmap_t pm) {
+#if WITH_XRENDER
+  auto it = m_pictures.find(pm);
+  if (it != m_pictures.end()) {
+    xcb_render_free_picture(m_connection, it->second);
+    m_pictures.erase(it);
+  }
+#endif
+  if (m_xftdraw != nullptr && XftDrawDrawable(m_xftdraw) == pm) {
+    cleanup();
+  }
+}
+
+bool font_manager::loaded() const {
+  return !m_fonts.empty();
+}
+
 bool font_manager::load(const string& name, uint8_t fontindex, int8_t offset_y) {
   if (fontindex > 0 && m_fonts.find(fontindex) != m_fonts.end()) {
     m_logger.warn("A font with index '%i' has already been loaded, skip...", fontindex);
@@ -102,6 +157,13 @@ bool font_manager::load(const string& name, uint8_t fontindex, int8_t offset_y)
     return false;
   }
 
+#if WITH_XRENDER
+  if (font->xft != nullptr && m_xrender) {
+    font->glyphset = m_connection.generate_id();
+    xcb_render_create_glyph_set(m_connection, font->glyphset, m_format_a8);
+  }
+#endif
+
   m_fonts.emplace(make_pair(fontindex, move(font)));
 
   int max_height{0};
@@ -130,7 +192,7 @@ void font_manager::fontindex(uint8_t index) {
   }
 }
 
-shared_ptr<font_ref> font_manager::match_char(const uint16_t chr) {
+shared_ptr<font_ref> font_manager::match_char(const uint32_t chr) {
   if (!m_fonts.empty()) {
     if (m_fontindex > 0 && static_cast<size_t>(m_fontindex) <= m_fonts.size()) {
       auto iter = m_fonts.find(m_fontindex);
@@ -154,7 +216,7 @@ shared_ptr<font_ref> font_manager::match_char(const uint16_t chr) {
   return {};
 }
 
-uint8_t font_manager::glyph_width(const shared_ptr<font_ref>& font, const uint16_t chr) {
+uint8_t font_manager::glyph_width(const shared_ptr<font_ref>& font, const uint32_t chr) {
   if (font && font->xft != nullptr) {
     return glyph_width_xft(move(font), chr);
   } else if (font && font->ptr != XCB_NONE) {
@@ -165,40 +227,101 @@ uint8_t font_manager::glyph_width(const shared_ptr<font_ref>& font, const uint16
 }
 
 void font_manager::drawtext(const shared_ptr<font_ref>& font, xcb_pixmap_t pm, xcb_gcontext_t gc, int16_t x, int16_t y,
-    const uint16_t* chars, size_t num_chars) {
-  if (m_xftdraw == nullptr) {
-    m_xftdraw = XftDrawCreate(m_display, pm, m_visual, m_colormap);
+    const uint32_t* chars, size_t num_chars) {
+#if WITH_XRENDER
+  if (font->glyphset != XCB_NONE) {
+    return xrender_composite_glyphs(font, xrender_picture(pm), x, y, chars, num_chars);
   }
+#endif
   if (font->xft != nullptr) {
-    XftDrawString16(m_xftdraw, &m_xftcolor, font->xft, x, y, chars, num_chars);
+    if (m_xftdraw == nullptr) {
+      m_xftdraw = XftDrawCreate(m_display, pm, m_visual, m_colormap);
+    } else if (XftDrawDrawable(m_xftdraw) != pm) {
+      XftDrawChange(m_xftdraw, pm);
+    }
+    XftDrawString32(m_xftdraw, &m_xftcolor, font->xft, x, y, reinterpret_cast<const FcChar32*>(chars), num_chars);
   } else if (font->ptr != XCB_NONE) {
-    vector<uint16_t> ucs(num_chars);
-    for (size_t i = 0; i < num_chars; i++) {
-      ucs[i] = (chars[i] >> 8) | (chars[i] << 8);
+    // Core fonts only cover the BMP, and a text request
+    // holds at most 254 big-endian characters
+    uint16_t ucs[254];
+    for (size_t pos = 0; pos < num_chars;) {
+      uint8_t len{0};
+      int16_t advance{0};
+      for (; len < sizeof(ucs) / sizeof(ucs[0]) && pos < num_chars; len++, pos++) {
+        ucs[len] = (chars[pos] >> 8 & 0xff) | (chars[pos] & 0xff) << 8;
+        advance += glyph_width_xcb(font, chars[pos]);
+      }
+      xcb_poly_text_16(pm, gc, x, y, len, ucs);
+      x += advance;
     }
-    xcb_poly_text_16(pm, gc, x, y, num_chars, ucs.data());
   }
 }
 
+/**
+ * Select the color used to draw text
+ *
+ * Pens and Xft colors are allocated once per color, the pools are
+ * released when they grow beyond COLOR_POOL_SIZE entries
+ */
 void font_manager::allocate_color(uint32_t color) {
-  // clang-format off
-  XRenderColor x{
-    color_util::red_channel<uint16_t>(color),
-    color_util::green_channel<uint16_t>(color),
-    color_util::blue_channel<uint16_t>(color),
-    color_util::alpha_channel<uint16_t>(color)};
-  // clang-format on
-  allocate_color(x);
-}
+#if WITH_XRENDER
+  if (m_xrender) {
+    auto it = m_pens.find(color);
+
+    if (it == m_pens.end()) {
+      if (m_pens.size() >= COLOR_POOL_SIZE) {
+        for (auto&& pen : m_pens) {
+          xcb_render_free_picture(m_connection, pen.second);
+        }
+        m_pens.clear();
+      }
+
+      // clang-format off
+      xcb_render_color_t pen{
+        color_util::red_channel<uint16_t>(color),
+        color_util::green_channel<uint16_t>(color),
+        color_util::blue_channel<uint16_t>(color),
+        color_util::alpha_channel<uint16_t>(color)};
+      // clang-format on
 
-void font_manager::allocate_color(XRenderColor color) {
-  if (m_xftcolor_allocated) {
-    XftColorFree(m_display, m_visual, m_colormap, &m_xftcolor);
+      it = m_pens.emplace(color, m_connection.generate_id()).first;
+      xcb_render_create_solid_fill(m_connection, it->second, pen);
+    }
+
+    m_pen = it->second;
+    return;
   }
+#endif
+
+  auto it = m_xftcolors.find(color);
+
+  if (it == m_xftcolors.end()) {
+    if (m_xftcolors.size() >= COLOR_POOL_SIZE) {
+      for (auto&& allocated : m_xftcolors) {
+        XftColorFree(m_display, m_visual, m_colormap, &allocated.second);
+      }
+      m_xftcolors.clear();
+    }
+
+    // clang-format off
+    XRenderColor x{
+      color_util::red_channel<uint16_t>(color),
+      color_util::green_channel<uint16_t>(color),
+      color_util::blue_channel<uint16_t>(color),
+      color_util::alpha_channel<uint16_t>(color)};
+    // clang-format on
+
+    XftColor allocated{};
+    if (!XftColorAllocValue(m_display, m_visual, m_colormap, &x, &allocated)) {
+      m_logger.err("Failed to allocate color");
+      m_xftcolor = XftColor{};
+      return;
+    }
 
-  if (!(m_xftcolor_allocated = XftColorAllocValue(m_display, m_visual, m_colormap, &color, &m_xftcolor))) {
-    m_logger.err("Failed to allocate color");
+    it = m_xftcolors.emplace(color, allocated).first;
   }
+
+  m_xftcolor = it->second;
 }
 
 bool font_manager::open_xcb_font(const shared_ptr<font_ref>& font, string fontname) {
@@ -233,12 +356,18 @@ bool font_manager::open_xcb_font(const shared_ptr<font_ref>& font, string fontna
   return false;
 }
 
-uint8_t font_manager::glyph_width_xft(const shared_ptr<font_ref>& font, const uint16_t chr) {
+uint8_t font_manager::glyph_width_xft(const shared_ptr<font_ref>& font, const uint32_t chr) {
   auto it = font->glyph_widths.find(chr);
   if (it != font->glyph_widths.end()) {
     return it->second;
   }
 
+#if WITH_XRENDER
+  if (font->glyphset != XCB_NONE) {
+    return load_glyph(font, chr);
+  }
+#endif
+
   XGlyphInfo extents{};
   FT_UInt glyph{XftCharIndex(m_display, font->xft, static_cast<FcChar32>(chr))};
 
@@ -251,7 +380,7 @@ uint8_t font_manager::glyph_width_xft(const shared_ptr<font_ref>& font, const ui
   return extents.xOff;
 }
 
-uint8_t font_manager::glyph_width_xcb(const shared_ptr<font_ref>& font, const uint16_t chr) {
+uint8_t font_manager::glyph_width_xcb(const shared_ptr<font_ref>& font, const uint32_t chr) {
   if (!font || font->ptr == XCB_NONE) {
     return 0;
   } else if (static_cast<size_t>(chr - font->char_min) < font->width_lut.size()) {
@@ -261,7 +390,7 @@ uint8_t font_manager::glyph_width_xcb(const shared_ptr<font_ref>& font, const ui
   }
 }
 
-bool font_manager::has_glyph_xft(const shared_ptr<font_ref>& font, const uint16_t chr) {
+bool font_manager::has_glyph_xft(const shared_ptr<font_ref>& font, const uint32_t chr) {
   if (!font || font->xft == nullptr) {
     return false;
   } else if (XftCharExists(m_display, font->xft, static_cast<FcChar32>(chr)) == FcFalse) {
@@ -271,7 +400,7 @@ bool font_manager::has_glyph_xft(const shared_ptr<font_ref>& font, const uint16_
   }
 }
 
-bool font_manager::has_glyph_xcb(const shared_ptr<font_ref>& font, const uint16_t chr) {
+bool font_manager::has_glyph_xcb(const shared_ptr<font_ref>& font, const uint32_t chr) {
   if (font->ptr == XCB_NONE) {
     return false;
   } else if (chr < font->char_min || chr > font->char_max) {
@@ -304,4 +433,157 @@ void font_manager::xcb_poly_text_16(
   xcb_send_request(m_connection, 0, xcb_parts + 2, &xcb_req);
 }
 
+#if WITH_XRENDER
+/**
+ * Find the picture formats used for the glyph masks and the target pixmaps
+ */
+bool font_manager::init_xrender() {
+  auto reply = xcb_render_query_pict_formats_reply(m_connection, xcb_render_query_pict_formats(m_connection), nullptr);
+
+  if (reply == nullptr) {
+    return false;
+  }
+
+  m_format_a8 = XCB_NONE;
+  m_format_visual = XCB_NONE;
+
+  for (auto formats = xcb_render_query_pict_formats_formats_iterator(reply); formats.rem;
+       xcb_render_pictforminfo_next(&formats)) {
+    const auto& f = *formats.data;
+    if (f.type == XCB_RENDER_PICT_TYPE_DIRECT && f.depth == 8 && f.direct.alpha_mask == 0xff &&
+        f.direct.red_mask == 0 && f.direct.green_mask == 0 && f.direct.blue_mask == 0) {
+      m_format_a8 = f.id;
+      break;
+    }
+  }
+
+  for (auto screens = xcb_render_query_pict_formats_screens_iterator(reply); screens.rem;
+       xcb_render_pictscreen_next(&screens)) {
+    for (auto depths = xcb_render_pictscreen_depths_iterator(screens.data); depths.rem;
+         xcb_render_pictdepth_next(&depths)) {
+      for (auto visuals = xcb_render_pictdepth_visuals_iterator(depths.data); visuals.rem;
+           xcb_render_pictvisual_next(&visuals)) {
+        if (visuals.data->visual == m_visual->visualid) {
+          m_format_visual = visuals.data->format;
+        }
+      }
+    }
+  }
+
+  free(reply);
+
+  return m_format_a8 != XCB_NONE && m_format_visual != XCB_NONE;
+}
+
+/**
+ * Rasterize the glyph of given character and add it to the glyph set
+ * of the font. Characters that fail to render get an empty glyph
+ *
+ * Returns the advance width of the glyph
+ */
+uint8_t font_manager::load_glyph(const shared_ptr<font_ref>& font, const uint32_t chr) {
+  xcb_render_glyphinfo_t info{};
+  vector<uint8_t> image;
+
+  FT_Face face{XftLockFace(font->xft)};
+
+  if (face != nullptr) {
+    FT_UInt index{XftCharIndex(m_display, font->xft, static_cast<FcChar32>(chr))};
+
+    if (FT_Load_Glyph(face, index, FT_LOAD_RENDER) == 0) {
+      const FT_GlyphSlot slot{face->glyph};
+      const FT_Bitmap& bitmap{slot->bitmap};
+
+      info.x_off = (slot->advance.x + 32) >> 6;
+
+      if (bitmap.pixel_mode == FT_PIXEL_MODE_GRAY || bitmap.pixel_mode == FT_PIXEL_MODE_MONO) {
+        info.width = bitmap.width;
+        info.height = bitmap.rows;
+        info.x = -slot->bitmap_left;
+        info.y = slot->bitmap_top;
+
+        // Rows of the uploaded A8 image are padded to 32 bits
+        size_t stride{(bitmap.width + 3) & ~3U};
+        image.resize(stride * bitmap.rows);
+
+        for (size_t y = 0; y < bitmap.rows; y++) {
+          const uint8_t* row{bitmap.buffer + static_cast<ptrdiff_t>(y) * bitmap.pitch};
+          for (size_t x = 0; x < bitmap.width; x++) {
+            if (bitmap.pixel_mode == FT_PIXEL_MODE_MONO) {
+              image[y * stride + x] = (row[x >> 3] & (0x80 >> (x & 7))) ? 0xff : 0x00;
+            } else {
+              image[y * stride + x] = row[x];
+            }
+          }
+        }
+      }
+    }
+
+    XftUnlockFace(font->xft);
+  }
+
+  uint32_t glyph{chr};
+  xcb_render_add_glyphs(m_connection, font->glyphset, 1, &glyph, &info, image.size(), image.data());
+  font->glyph_widths.emplace(chr, info.x_off);
+
+  return info.x_off;
+}
+
+/**
+ * Get the picture used to draw onto given pixmap
+ */
+xcb_render_picture_t font_manager::xrender_picture(xcb_pixmap_t pm) {
+  auto it = m_pictures.find(pm);
+  if (it != m_pictures.end()) {
+    return it->second;
+  }
+
+  xcb_render_picture_t picture{m_connection.generate_id()};
+  xcb_render_create_picture(m_connection, picture, pm, m_format_visual, 0, nullptr);
+  m_pictures.emplace(pm, picture);
+
+  return picture;
+}
+
+/**
+ * Draw the glyphs of given characters using the current pen
+ *
+ * Glyphs that have not been uploaded yet are added to
+ * the glyph set before the request is sent
+ */
+void font_manager::xrender_composite_glyphs(const shared_ptr<font_ref>& font, xcb_render_picture_t dst, int16_t x,
+    int16_t y, const uint32_t* chars, size_t num_chars) {
+  // A glyph element holds at most 254 glyphs
+  static constexpr size_t max_glyphs{254};
+
+  vector<uint8_t> elts;
+  elts.reserve(num_chars * sizeof(uint32_t) + (num_chars / max_glyphs + 1) * sizeof(xcb_render_glyph_elt_t));
+
+  for (size_t pos = 0; pos < num_chars; pos += max_glyphs) {
+    xcb_render_glyph_elt_t elt{};
+    elt.count = static_cast<uint8_t>(std::min(max_glyphs, num_chars - pos));
+
+    // Subsequent elements continue where the previous one ended
+    if (pos == 0) {
+      elt.deltax = x;
+      elt.deltay = y;
+    }
+
+    auto header = reinterpret_cast<const uint8_t*>(&elt);
+    elts.insert(elts.end(), header, header + sizeof(elt));
+
+    for (size_t i = pos; i < pos + elt.count; i++) {
+      if (font->glyph_widths.find(chars[i]) == font->glyph_widths.end()) {
+        load_glyph(font, chars[i]);
+      }
+      auto glyph = reinterpret_cast<const uint8_t*>(&chars[i]);
+      elts.insert(elts.end(), glyph, glyph + sizeof(uint32_t));
+    }
+  }
+
+  xcb_render_composite_glyphs_32(m_connection, XCB_RENDER_PICT_OP_OVER, m_pen, dst, m_format_a8, font->glyphset, 0, 0,
+      elts.size(), elts.data());
+}
+#endif
+
 POLYBAR_NS_END
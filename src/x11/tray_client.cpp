@@ -53,9 +53,25 @@ bool tray_client::mapped() const {
  * Set client window mapped state
  */
 void tray_client::mapped(bool state) {
+  m_dirty = m_dirty || (state && !m_mapped);
   m_mapped = state;
 }
 
+/**
+ * Check if the window needs to be cleared to
+ * show the current tray background
+ */
+bool tray_client::dirty() const {
+  return m_dirty;
+}
+
+/**
+ * Set client window dirty state
+ */
+void tray_client::dirty(bool state) {
+  m_dirty = state;
+}
+
 /**
  * Get client window
  */
@@ -82,9 +98,11 @@ void tray_client::ensure_state() const {
 }
 
 /**
- * Configure window size
+ * Configure window size and position
+ *
+ * The window is marked as dirty if it moved
  */
-void tray_client::reconfigure(int16_t x, int16_t y) const {
+void tray_client::reconfigure(int16_t x, int16_t y) {
   uint32_t configure_mask = 0;
   uint32_t configure_values[7];
   xcb_params_configure_window_t configure_params{};
@@ -96,6 +114,10 @@ void tray_client::reconfigure(int16_t x, int16_t y) const {
 
   connection::pack_values(configure_mask, &configure_params, configure_values);
   m_connection.configure_window_checked(window(), configure_mask, configure_values);
+
+  m_dirty = m_dirty || x != m_x || y != m_y;
+  m_x = x;
+  m_y = y;
 }
 
 /**
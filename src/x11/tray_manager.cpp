@@ -1,8 +1,8 @@
 #include <xcb/xcb_icccm.h>
 #include <xcb/xcb_image.h>
-#include <thread>
 
 #include "components/config.hpp"
+#include "components/taskqueue.hpp"
 #include "components/types.hpp"
 #include "errors.hpp"
 #include "events/signal.hpp"
@@ -46,18 +46,18 @@ using namespace wm_util;
  * Create instance
  */
 tray_manager::make_type tray_manager::make() {
-  return factory_util::unique<tray_manager>(connection::make(), signal_emitter::make(), logger::make());
+  return factory_util::unique<tray_manager>(
+      connection::make(), signal_emitter::make(), logger::make(), taskqueue::make());
 }
 
-tray_manager::tray_manager(connection& conn, signal_emitter& emitter, const logger& logger)
-    : m_connection(conn), m_sig(emitter), m_log(logger) {
+tray_manager::tray_manager(
+    connection& conn, signal_emitter& emitter, const logger& logger, unique_ptr<taskqueue>&& taskqueue)
+    : m_connection(conn), m_sig(emitter), m_log(logger), m_taskqueue(forward<decltype(taskqueue)>(taskqueue)) {
   m_connection.attach_sink(this, SINK_PRIORITY_TRAY);
 }
 
 tray_manager::~tray_manager() {
-  if (m_delaythread.joinable()) {
-    m_delaythread.join();
-  }
+  m_taskqueue.reset();
   m_connection.detach_sink(this, SINK_PRIORITY_TRAY);
   deactivate();
 }
@@ -292,13 +292,16 @@ void tray_manager::deactivate(bool clear_selection) {
 
 /**
  * Reconfigure tray
+ *
+ * Waits for a redraw in progress on the taskqueue thread rather than
+ * skipping the update, which would leave the client layout stale
  */
 void tray_manager::reconfigure() {
-  if (!m_tray || !m_mtx.try_lock()) {
+  if (!m_tray) {
     return;
   }
 
-  std::unique_lock<mutex> guard(m_mtx, std::adopt_lock);
+  std::unique_lock<mutex> guard(m_mtx);
 
   try {
     reconfigure_clients();
@@ -306,6 +309,11 @@ void tray_manager::reconfigure() {
     m_log.err("Failed to reconfigure tray clients (%s)", err.what());
   }
 
+  // The background slice changes when the window is moved or resized,
+  // in which case every client needs to be cleared
+  auto prev_x = m_opts.configured_x;
+  auto prev_w = m_opts.configured_w;
+
   try {
     reconfigure_window();
   } catch (const exception& err) {
@@ -322,7 +330,7 @@ void tray_manager::reconfigure() {
 
   guard.unlock();
 
-  refresh_window();
+  refresh_window(m_opts.configured_x != prev_x || m_opts.configured_w != prev_w);
 
   m_connection.flush();
 
@@ -447,43 +455,30 @@ void tray_manager::reconfigure_bg(bool realloc) {
     h -= py + h - m_rootpixmap.height;
   }
 
-  if (realloc) {
-    vector<uint8_t> image_data;
-    uint8_t image_depth;
-
-    try {
-      auto image_reply =
-          m_connection.get_image(XCB_IMAGE_FORMAT_Z_PIXMAP, m_rootpixmap.pixmap, px, py, w, h, XCB_COPY_PLANE);
-      image_depth = image_reply->depth;
-      std::back_insert_iterator<decltype(image_data)> back_it(image_data);
-      std::copy(image_reply.data().begin(), image_reply.data().end(), back_it);
-    } catch (const exception& err) {
-      m_log.err("Failed to get slice of root pixmap (%s)", err.what());
-      return;
-    }
-
-    try {
-      m_connection.put_image_checked(
-          XCB_IMAGE_FORMAT_Z_PIXMAP, m_pixmap, m_gc, w, h, 0, 0, 0, image_depth, image_data.size(), image_data.data());
-    } catch (const exception& err) {
-      m_log.err("Failed to store slice of root pixmap (%s)", err.what());
-      return;
-    }
-  }
-
+  // The background slice is copied server-side, no pixel data is transferred
   m_connection.copy_area_checked(m_rootpixmap.pixmap, m_pixmap, m_gc, px, py, 0, 0, w, h);
 }
 
 /**
- * Refresh the bar window by clearing it along with each client window
+ * Refresh the tray window by clearing it along with the client windows
  */
-void tray_manager::refresh_window() {
-  if (!m_activated || !m_mapped || !m_mtx.try_lock()) {
+void tray_manager::refresh_window(bool clear_clients) {
+  std::lock_guard<mutex> lock(m_mtx);
+  refresh_window_unlocked(clear_clients);
+}
+
+/**
+ * Refresh the tray window, the caller must hold `m_mtx`
+ *
+ * Only clients that have been moved or mapped since the last refresh
+ * are cleared, unless `clear_clients` is set because the background
+ * itself has changed. Clearing a client makes it repaint its contents
+ */
+void tray_manager::refresh_window_unlocked(bool clear_clients) {
+  if (!m_activated || !m_mapped) {
     return;
   }
 
-  std::lock_guard<mutex> lock(m_mtx, std::adopt_lock);
-
   m_log.trace("tray: Refreshing window");
 
   auto width = calculate_w();
@@ -496,7 +491,10 @@ void tray_manager::refresh_window() {
   m_connection.clear_area(0, m_tray, 0, 0, width, height);
 
   for (auto&& client : m_clients) {
-    client->clear_window();
+    if (clear_clients || client->dirty()) {
+      client->clear_window();
+      client->dirty(false);
+    }
   }
 
   m_connection.flush();
@@ -509,20 +507,25 @@ void tray_manager::refresh_window() {
 }
 
 /**
- * Redraw window
+ * Schedule a redraw of the window
+ *
+ * Redraws are limited to one per 24ms. Requests arriving within that
+ * window are merged into a single redraw at the end of it, so the
+ * last request is always honored. The redraw runs on the taskqueue
+ * thread, so it waits for `m_mtx` instead of racing with reconfigure()
  */
 void tray_manager::redraw_window(bool realloc_bg) {
-  chrono::system_clock::time_point now{chrono::system_clock::now()};
-
-  if (!realloc_bg && now - 24ms < m_drawtime) {
-    return m_log.trace("tray: Ignoring redraw (throttled)");
+  if (realloc_bg) {
+    m_realloc_bg = true;
   }
 
-  m_drawtime = chrono::time_point_cast<chrono::milliseconds>(now);
-  m_log.info("Redraw tray container (id=%s) %lu", m_connection.id(m_tray),
-      chrono::duration_cast<chrono::microseconds>(chrono::system_clock::now().time_since_epoch()));
-  reconfigure_bg(realloc_bg);
-  refresh_window();
+  m_taskqueue->throttle("tray-redraw", 24ms, [this](size_t) {
+    std::lock_guard<mutex> lock(m_mtx);
+    bool realloc{m_realloc_bg.exchange(false)};
+    m_log.trace("tray: Redraw container (id=%s, realloc_bg=%i)", m_connection.id(m_tray), realloc);
+    reconfigure_bg(realloc);
+    refresh_window_unlocked(realloc);
+  });
 }
 
 /**
@@ -726,13 +729,7 @@ void tray_manager::notify_clients() {
  * Send delayed notification to pending clients
  */
 void tray_manager::notify_clients_delayed() {
-  if (m_delaythread.joinable()) {
-    m_delaythread.join();
-  }
-  m_delaythread = thread([this]() {
-    this_thread::sleep_for(1s);
-    notify_clients();
-  });
+  m_taskqueue->defer_unique("tray-notify", 1s, [this](size_t) { notify_clients(); });
 }
 
 /**
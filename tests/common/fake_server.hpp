@@ -0,0 +1,323 @@
+#pragma once
+
+#include <sys/socket.h>
+#include <unistd.h>
+#include <xcb/xcb.h>
+#include <algorithm>
+#include <cstring>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * In-process stand-in for an X server
+ *
+ * The client end of a socket pair is handed to xcb, the server end is
+ * read by a thread that completes the connection setup, records every
+ * request and answers the ones that expect a reply with an empty reply.
+ * This makes it possible to count the requests issued by a piece of
+ * code without a running X server.
+ *
+ * Replies carry no data, except for QueryExtension which reports every
+ * extension (except BIG-REQUESTS) as present
+ *
+ * Only xcb is connected, there is no Xlib Display. Code that needs one,
+ * like the font manager (and through it the renderer), can't be driven
+ * against the fake server
+ */
+class fake_server {
+ public:
+  static constexpr xcb_window_t ROOT{0x100};
+  static constexpr xcb_visualid_t VISUAL{0x21};
+
+  struct request {
+    uint8_t opcode;
+    uint8_t minor;
+    uint16_t sequence;
+    std::vector<uint8_t> data;
+  };
+
+  explicit fake_server() {
+    int fds[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == -1) {
+      throw std::runtime_error("Failed to create socket pair");
+    }
+    m_client = fds[0];
+    m_server = fds[1];
+    m_thread = std::thread(&fake_server::serve, this);
+  }
+
+  ~fake_server() {
+    shutdown(m_server, SHUT_RDWR);
+    m_thread.join();
+    close(m_server);
+  }
+
+  /**
+   * Open a connection to the server, ownership of the socket
+   * is passed on to xcb
+   */
+  xcb_connection_t* connect() {
+    return xcb_connect_to_fd(m_client, nullptr);
+  }
+
+  /**
+   * Wait until all requests sent on the connection have been recorded
+   *
+   * The GetInputFocus round trip used for this is not recorded
+   */
+  void sync(xcb_connection_t* conn) {
+    free(xcb_get_input_focus_reply(conn, xcb_get_input_focus(conn), nullptr));
+    std::lock_guard<std::mutex> guard(m_lock);
+    m_requests.pop_back();
+  }
+
+  std::vector<request> requests() const {
+    std::lock_guard<std::mutex> guard(m_lock);
+    return m_requests;
+  }
+
+  size_t count(uint8_t opcode) const {
+    std::lock_guard<std::mutex> guard(m_lock);
+    size_t n{0};
+    for (auto&& r : m_requests) {
+      n += r.opcode == opcode;
+    }
+    return n;
+  }
+
+  void clear() {
+    std::lock_guard<std::mutex> guard(m_lock);
+    m_requests.clear();
+  }
+
+ protected:
+  bool read_all(void* buffer, size_t len) {
+    auto* pos = static_cast<uint8_t*>(buffer);
+    while (len > 0) {
+      auto n = read(m_server, pos, len);
+      if (n <= 0) {
+        return false;
+      }
+      pos += n;
+      len -= n;
+    }
+    return true;
+  }
+
+  void write_all(const void* buffer, size_t len) {
+    auto* pos = static_cast<const uint8_t*>(buffer);
+    while (len > 0) {
+      auto n = write(m_server, pos, len);
+      if (n <= 0) {
+        return;
+      }
+      pos += n;
+      len -= n;
+    }
+  }
+
+  static size_t pad(size_t len) {
+    return (len + 3) & ~3U;
+  }
+
+  bool handshake() {
+    xcb_setup_request_t req{};
+    if (!read_all(&req, sizeof(req))) {
+      return false;
+    }
+    std::vector<uint8_t> auth(pad(req.authorization_protocol_name_len) + pad(req.authorization_protocol_data_len));
+    if (!auth.empty() && !read_all(auth.data(), auth.size())) {
+      return false;
+    }
+
+    const std::string vendor{"polybar"};
+    std::vector<uint8_t> setup(sizeof(xcb_setup_t) + pad(vendor.size()) + sizeof(xcb_format_t) +
+                               sizeof(xcb_screen_t) + sizeof(xcb_depth_t) + sizeof(xcb_visualtype_t));
+    auto* pos = setup.data();
+
+    auto* s = reinterpret_cast<xcb_setup_t*>(pos);
+    s->status = 1;
+    s->protocol_major_version = 11;
+    s->length = (setup.size() - 8) / 4;
+    s->resource_id_base = 0x00400000;
+    s->resource_id_mask = 0x001fffff;
+    s->vendor_len = vendor.size();
+    s->maximum_request_length = 0xffff;
+    s->roots_len = 1;
+    s->pixmap_formats_len = 1;
+    s->bitmap_format_scanline_unit = 32;
+    s->bitmap_format_scanline_pad = 32;
+    s->min_keycode = 8;
+    s->max_keycode = 255;
+    pos += sizeof(xcb_setup_t);
+
+    memcpy(pos, vendor.data(), vendor.size());
+    pos += pad(vendor.size());
+
+    auto* format = reinterpret_cast<xcb_format_t*>(pos);
+    format->depth = 24;
+    format->bits_per_pixel = 32;
+    format->scanline_pad = 32;
+    pos += sizeof(xcb_format_t);
+
+    auto* screen = reinterpret_cast<xcb_screen_t*>(pos);
+    screen->root = ROOT;
+    screen->width_in_pixels = 1920;
+    screen->height_in_pixels = 1080;
+    screen->root_visual = VISUAL;
+    screen->root_depth = 24;
+    screen->allowed_depths_len = 1;
+    pos += sizeof(xcb_screen_t);
+
+    auto* depth = reinterpret_cast<xcb_depth_t*>(pos);
+    depth->depth = 24;
+    depth->visuals_len = 1;
+    pos += sizeof(xcb_depth_t);
+
+    auto* visual = reinterpret_cast<xcb_visualtype_t*>(pos);
+    visual->visual_id = VISUAL;
+    visual->_class = XCB_VISUAL_CLASS_TRUE_COLOR;
+    visual->bits_per_rgb_value = 8;
+    visual->colormap_entries = 256;
+    visual->red_mask = 0xff0000;
+    visual->green_mask = 0x00ff00;
+    visual->blue_mask = 0x0000ff;
+
+    write_all(setup.data(), setup.size());
+    return true;
+  }
+
+  /**
+   * Check if the request expects a reply
+   */
+  static bool has_reply(uint8_t opcode, uint8_t minor) {
+    switch (opcode) {
+      case 3:
+      case 14:
+      case 15:
+      case 16:
+      case 17:
+      case 20:
+      case 21:
+      case 23:
+      case 26:
+      case 31:
+      case 38:
+      case 39:
+      case 40:
+      case 43:
+      case 44:
+      case 47:
+      case 48:
+      case 49:
+      case 52:
+      case 73:
+      case 83:
+      case 84:
+      case 85:
+      case 86:
+      case 87:
+      case 91:
+      case 92:
+      case 97:
+      case 98:
+      case 99:
+      case 101:
+      case 103:
+      case 106:
+      case 108:
+      case 110:
+      case 116:
+      case 117:
+      case 118:
+      case 119:
+        return true;
+      default:
+        // Only the version handshake of extensions (minor opcode 0) is answered
+        return opcode >= 128 && minor == 0;
+    }
+  }
+
+  void reply(const request& req) {
+    uint8_t buffer[44]{};
+    size_t len{32};
+
+    buffer[0] = 1;
+    memcpy(&buffer[2], &req.sequence, sizeof(req.sequence));
+
+    if (req.opcode == XCB_GET_WINDOW_ATTRIBUTES) {
+      uint32_t extra{3};
+      memcpy(&buffer[4], &extra, sizeof(extra));
+      len = 44;
+    } else if (req.opcode == XCB_QUERY_EXTENSION && req.data.size() >= 8) {
+      uint16_t name_len;
+      memcpy(&name_len, &req.data[4], sizeof(name_len));
+      std::string name(req.data.begin() + 8, req.data.begin() + 8 + std::min<size_t>(name_len, req.data.size() - 8));
+      if (name != "BIG-REQUESTS") {
+        buffer[8] = 1;
+        buffer[9] = m_extensions + 128;
+        buffer[10] = 64 + m_extensions * 8;
+        buffer[11] = 128 + m_extensions * 8;
+        m_extensions++;
+      }
+    }
+
+    write_all(buffer, len);
+  }
+
+  void serve() {
+    if (!handshake()) {
+      return;
+    }
+
+    for (uint16_t sequence = 1;; sequence++) {
+      request req{};
+      uint8_t header[4];
+
+      if (!read_all(header, sizeof(header))) {
+        return;
+      }
+
+      uint32_t len{static_cast<uint32_t>(header[2] | header[3] << 8) * 4U};
+      req.data.assign(header, header + sizeof(header));
+
+      if (len == 0) {
+        uint8_t big[4];
+        if (!read_all(big, sizeof(big))) {
+          return;
+        }
+        memcpy(&len, big, sizeof(len));
+        len = len * 4U - sizeof(big);
+      }
+
+      req.data.resize(req.data.size() + len - sizeof(header));
+      if (len > sizeof(header) && !read_all(req.data.data() + sizeof(header), len - sizeof(header))) {
+        return;
+      }
+
+      req.opcode = header[0];
+      req.minor = header[1];
+      req.sequence = sequence;
+
+      {
+        std::lock_guard<std::mutex> guard(m_lock);
+        m_requests.emplace_back(req);
+      }
+
+      if (has_reply(req.opcode, req.minor)) {
+        reply(req);
+      }
+    }
+  }
+
+ private:
+  int m_client{-1};
+  int m_server{-1};
+  std::thread m_thread;
+  mutable std::mutex m_lock;
+  std::vector<request> m_requests;
+  uint8_t m_extensions{0};
+};
@@ -0,0 +1,64 @@
+#include "components/action_index.cpp"
+
+int main() {
+  using namespace polybar;
+
+  const auto block = [](mousebtn button, string command, double start_x, double end_x) {
+    action_block action{};
+    action.button = button;
+    action.command = move(command);
+    action.start_x = start_x;
+    action.end_x = end_x;
+    action.active = false;
+    return action;
+  };
+
+  "find"_test = [&] {
+    action_index index{vector<action_block>{block(mousebtn::LEFT, "a", 0, 10), block(mousebtn::LEFT, "b", 20, 30),
+        block(mousebtn::RIGHT, "c", 0, 30)}};
+
+    expect(index.find(mousebtn::LEFT, 0) == nullptr);
+    expect(index.find(mousebtn::LEFT, 1)->command == "a");
+    expect(index.find(mousebtn::LEFT, 10)->command == "a");
+    expect(index.find(mousebtn::LEFT, 11) == nullptr);
+    expect(index.find(mousebtn::LEFT, 25)->command == "b");
+    expect(index.find(mousebtn::LEFT, 31) == nullptr);
+    expect(index.find(mousebtn::RIGHT, 15)->command == "c");
+    expect(index.find(mousebtn::MIDDLE, 5) == nullptr);
+  };
+
+  "nested"_test = [&] {
+    action_index index{vector<action_block>{block(mousebtn::LEFT, "outer", 0, 100),
+        block(mousebtn::LEFT, "inner", 40, 60), block(mousebtn::SCROLL_UP, "scroll", 40, 60)}};
+
+    expect(index.find(mousebtn::LEFT, 50)->command == "outer");
+    expect(index.find(mousebtn::LEFT, 80)->command == "outer");
+    expect(index.find(mousebtn::SCROLL_UP, 50)->command == "scroll");
+    expect(index.find(mousebtn::SCROLL_UP, 80) == nullptr);
+  };
+
+  "inactive"_test = [&] {
+    auto open = block(mousebtn::DOUBLE_LEFT, "open", 0, 10);
+    open.active = true;
+    action_index index{vector<action_block>{open, block(mousebtn::LEFT, "empty", 5, 5)}};
+
+    expect(index.find(mousebtn::DOUBLE_LEFT, 5) == nullptr);
+    expect(index.find(mousebtn::LEFT, 5) == nullptr);
+    expect(!index.has(mousebtn::DOUBLE_LEFT));
+    expect(!index.has(mousebtn::LEFT));
+    expect(!action_index{}.has(mousebtn::LEFT));
+  };
+
+  "many"_test = [&] {
+    vector<action_block> blocks;
+    for (int i = 0; i < 200; i++) {
+      blocks.emplace_back(block(mousebtn::LEFT, to_string(i), i * 10, i * 10 + 8));
+    }
+    action_index index{move(blocks)};
+
+    for (int i = 0; i < 200; i++) {
+      expect(index.find(mousebtn::LEFT, i * 10 + 4)->command == to_string(i));
+      expect(index.find(mousebtn::LEFT, i * 10 + 9) == nullptr);
+    }
+  };
+}
@@ -0,0 +1,77 @@
+#include "components/action_router.cpp"
+
+using namespace polybar;
+
+class handler : public modules::input_handler {
+ public:
+  explicit handler(string accept) : m_accept(move(accept)) {}
+
+  bool input(string&& cmd) {
+    received.emplace_back(cmd);
+    return cmd == m_accept;
+  }
+
+  vector<string> received;
+
+ private:
+  string m_accept;
+};
+
+int main() {
+  "prefix"_test = [] {
+    expect(action_router::prefix(12) == "#12.");
+    expect(action_router::strip("#12.volup") == "volup");
+    expect(action_router::strip("volup") == "volup");
+    expect(action_router::strip("#volup") == "#volup");
+    expect(action_router::strip("#12volup") == "#12volup");
+  };
+
+  "routed"_test = [] {
+    handler first{"toggle"};
+    handler second{"toggle"};
+    action_router router;
+    router.add(1, &first);
+    router.add(2, &second);
+
+    string action{action_router::prefix(2) + "toggle"};
+    expect(router.dispatch(action));
+    expect(action == "toggle");
+    expect(first.received.empty());
+    expect(second.received.size() == 1);
+  };
+
+  "unrouted"_test = [] {
+    handler first{"next"};
+    handler second{"toggle"};
+    action_router router;
+    router.add(1, &first);
+    router.add(2, &second);
+
+    string action{"toggle"};
+    expect(router.dispatch(action));
+    expect(first.received.size() == 1);
+    expect(second.received.size() == 1);
+  };
+
+  "declined"_test = [] {
+    handler first{"next"};
+    handler second{"toggle"};
+    action_router router;
+    router.add(1, &first);
+    router.add(2, &second);
+
+    string action{action_router::prefix(1) + "toggle"};
+    expect(router.dispatch(action));
+    expect(first.received.size() == 1);
+    expect(second.received.size() == 1);
+
+    action = action_router::prefix(3) + "firefox";
+    expect(!router.dispatch(action));
+    expect(action == "firefox");
+
+    router.clear();
+    action = action_router::prefix(2) + "toggle";
+    expect(!router.dispatch(action));
+    expect(second.received.size() == 2);
+  };
+}
@@ -0,0 +1,264 @@
+#include <unistd.h>
+#include <fstream>
+
+#include "components/config.cpp"
+#include "components/logger.cpp"
+#include "utils/concurrency.cpp"
+#include "utils/env.cpp"
+#include "utils/file.cpp"
+#include "utils/string.cpp"
+
+POLYBAR_NS
+
+// The tests don't rely on X resources or colors, so those
+// are stubbed out instead of connecting to X
+color::color(string hex) : m_value(0), m_color(0), m_source(move(hex)) {}
+
+xresource_manager::make_type xresource_manager::make() {
+  return *factory_util::singleton<xresource_manager>(nullptr);
+}
+xresource_manager::xresource_manager(Display*) : m_db(nullptr) {}
+xresource_manager::~xresource_manager() {}
+string xresource_manager::get_string(string, string fallback) const {
+  return fallback;
+}
+
+POLYBAR_NS_END
+
+int main() {
+  using namespace polybar;
+
+  const auto write_config = [](const string& contents) {
+    char path[]{"/tmp/polybar_config_test.XXXXXX"};
+    int fd{mkstemp(path)};
+    if (fd == -1) {
+      return string{};
+    }
+    close(fd);
+    std::ofstream out(path);
+    out << contents;
+    return string{path};
+  };
+
+  const auto& log = logger::make(loglevel::NONE);
+  const auto& xrm = xresource_manager::make();
+
+  "parse"_test = [&] {
+    auto path = write_config(
+        "[bar/top]\n"
+        "width = 100%\n"
+        "\theight=  24 \n"
+        "; comment = ignored\n"
+        "label = \" padded \"\n"
+        "enabled = yes\n");
+    config conf{log, xrm, string{path}, "top"};
+    expect(conf.get<string>("bar/top", "width") == "100%");
+    expect(conf.get<int>("bar/top", "height") == 24);
+    expect(conf.get<string>("bar/top", "label") == " padded ");
+    expect(conf.get<bool>("bar/top", "enabled"));
+    expect(conf.get<bool>("bar/top", "enabled"));
+    expect(!conf.has("bar/top", "comment"));
+    expect(conf.get<int>("bar/top", "missing", 5) == 5);
+    unlink(path.c_str());
+  };
+
+  "references"_test = [&] {
+    setenv("POLYBAR_CONFIG_TEST", "env value", 1);
+    auto path = write_config(
+        "[colors]\n"
+        "primary = #ff0000\n"
+        "alias = ${colors.primary}\n"
+        "[bar/top]\n"
+        "color = ${colors.alias}\n"
+        "own = ${self.color}\n"
+        "root = ${root.own}\n"
+        "env = ${env:POLYBAR_CONFIG_TEST}\n"
+        "env-fallback = ${env:POLYBAR_CONFIG_TEST_UNSET:fallback}\n"
+        "invalid = ${invalid}\n"
+        "missing = ${colors.missing}\n"
+        "cycle-a = ${self.cycle-b}\n"
+        "cycle-b = ${self.cycle-a}\n");
+    config conf{log, xrm, string{path}, "top"};
+    expect(conf.get<string>("bar/top", "color") == "#ff0000");
+    expect(conf.get<string>("bar/top", "own") == "#ff0000");
+    expect(conf.get<string>("bar/top", "root") == "#ff0000");
+    expect(conf.get<string>("bar/top", "env") == "env value");
+    expect(conf.get<string>("bar/top", "env-fallback") == "fallback");
+
+    for (auto&& key : {"invalid", "missing", "cycle-a", "cycle-b"}) {
+      auto thrown = false;
+      try {
+        conf.get<string>("bar/top", key);
+      } catch (const value_error&) {
+        thrown = true;
+      }
+      expect(thrown);
+    }
+    unlink(path.c_str());
+  };
+
+  "inherit"_test = [&] {
+    auto path = write_config(
+        "[module/derived]\n"
+        "inherit = module/middle\n"
+        "own = derived\n"
+        "[module/middle]\n"
+        "inherit = module/base\n"
+        "own = middle\n"
+        "middle = ${self.own}\n"
+        "[module/base]\n"
+        "own = base\n"
+        "base = base\n"
+        "[bar/top]\n"
+        "width = 1\n");
+    config conf{log, xrm, string{path}, "top"};
+    expect(conf.get<string>("module/derived", "own") == "derived");
+    expect(conf.get<string>("module/derived", "middle") == "derived");
+    expect(conf.get<string>("module/derived", "base") == "base");
+    expect(conf.get<string>("module/middle", "base") == "base");
+    expect(conf.get<string>("module/middle", "middle") == "middle");
+    unlink(path.c_str());
+  };
+
+  "inherit_cycle"_test = [&] {
+    auto path = write_config(
+        "[module/a]\n"
+        "inherit = module/b\n"
+        "[module/b]\n"
+        "inherit = module/a\n"
+        "[bar/top]\n"
+        "width = 1\n");
+    auto thrown = false;
+    try {
+      config conf{log, xrm, string{path}, "top"};
+    } catch (const value_error&) {
+      thrown = true;
+    }
+    expect(thrown);
+    unlink(path.c_str());
+  };
+
+  "list"_test = [&] {
+    auto path = write_config(
+        "[bar/top]\n"
+        "font-2 = c\n"
+        "font-0 = a\n"
+        "font-1 = ${self.font-0}\n"
+        "font-4 = gap\n"
+        "ramp-01 = ignored\n");
+    config conf{log, xrm, string{path}, "top"};
+    expect(conf.get_list<string>("bar/top", "font") == vector<string>({"a", "a", "c"}));
+    expect(conf.get_list<string>("bar/top", "ramp", {"x"}) == vector<string>({"x"}));
+    unlink(path.c_str());
+  };
+
+  "set"_test = [&] {
+    auto path = write_config(
+        "[bar/top]\n"
+        "label = %percentage%\n"
+        "alias = ${self.label}\n"
+        "other = unchanged\n"
+        "item-0 = a\n"
+        "[module/a]\n"
+        "chained = ${root.alias}\n");
+    config conf{log, xrm, string{path}, "top"};
+    expect(conf.get<string>("bar/top", "alias") == "%percentage%");
+    const_cast<config&>(conf).set("bar/top", "label", "updated");
+    expect(conf.get<string>("bar/top", "label") == "updated");
+    expect(conf.get<string>("bar/top", "alias") == "updated");
+    expect(conf.get<string>("module/a", "chained") == "updated");
+    expect(conf.get<string>("bar/top", "other") == "unchanged");
+    const_cast<config&>(conf).set("module/new", "key", "value");
+    expect(conf.get<string>("module/new", "key") == "value");
+    const_cast<config&>(conf).set("bar/top", "item-1", "b");
+    expect(conf.get_list<string>("bar/top", "item") == vector<string>({"a", "b"}));
+    unlink(path.c_str());
+  };
+
+  "reload"_test = [&] {
+    auto path = write_config(
+        "[colors]\n"
+        "primary = #f00\n"
+        "[module/a]\n"
+        "color = ${colors.primary}\n"
+        "[module/b]\n"
+        "label = b\n"
+        "[module/c]\n"
+        "label = c\n"
+        "[bar/top]\n"
+        "modules-left = a b c\n");
+    config conf{log, xrm, string{path}, "top"};
+
+    std::ofstream(path) << "[colors]\n"
+                           "primary = #0f0\n"
+                           "[module/a]\n"
+                           "color = ${colors.primary}\n"
+                           "[module/b]\n"
+                           "label = b\n"
+                           "[module/d]\n"
+                           "label = d\n"
+                           "[bar/top]\n"
+                           "modules-left = a b d\n";
+
+    auto changes = conf.reload();
+    expect(changes.size() == 5);
+    expect(changes["colors"] == vector<string>({"primary"}));
+    expect(changes["module/a"] == vector<string>({"color"}));
+    expect(changes["module/c"] == vector<string>({"label"}));
+    expect(changes["module/d"] == vector<string>({"label"}));
+    expect(changes["bar/top"] == vector<string>({"modules-left"}));
+    expect(changes.find("module/b") == changes.end());
+    expect(conf.get<string>("module/a", "color") == "#0f0");
+    expect(!conf.has("module/c", "label"));
+
+    std::ofstream(path) << "[bar/top]\n"
+                           "key = 1\n"
+                           "key = 2\n";
+
+    auto thrown = false;
+    try {
+      conf.reload();
+    } catch (const key_error&) {
+      thrown = true;
+    }
+    expect(thrown);
+    expect(conf.get<string>("module/d", "label") == "d");
+    unlink(path.c_str());
+  };
+
+  "inherit_chain"_test = [&] {
+    // Each module section inherits from a chain of base sections
+    string contents{"[colors]\nbackground = #222\nforeground = #dfdfdf\n\n"};
+    const size_t sections{64};
+
+    for (size_t i = 0; i < sections; i++) {
+      contents += "[module/m" + to_string(i) + "]\n";
+      if (i > 0) {
+        contents += "inherit = module/m" + to_string(i / 2) + "\n";
+      }
+      for (size_t k = 0; k < 8; k++) {
+        contents += "key" + to_string(i) + "-" + to_string(k) + " = ${colors.foreground}\n";
+      }
+      contents += "format-background = ${colors.background}\n";
+      contents += "label = %name% " + to_string(i) + "\n\n";
+    }
+    contents += "[bar/top]\nmodules-left = m1 m2 m3\n";
+
+    auto path = write_config(contents);
+    config conf{log, xrm, string{path}, "top"};
+
+    for (size_t i = 0; i < sections; i++) {
+      string name{"module/m" + to_string(i)};
+      expect(conf.get<string>(name, "format-background") == "#222");
+      expect(conf.get<string>(name, "label", ""s) == "%name% " + to_string(i));
+      expect(conf.get_list<string>(name, "key" + to_string(i)).size() == 8);
+      expect(conf.get<int>(name, "missing", 0) == 0);
+    }
+
+    // module/m5 inherits from m2, m1 and m0 but not from m3
+    expect(conf.get_list<string>("module/m5", "key2") == vector<string>(8, "#dfdfdf"));
+    expect(conf.get_list<string>("module/m5", "key1").size() == 8);
+    expect(!conf.has("module/m5", "key3-0"));
+    unlink(path.c_str());
+  };
+}
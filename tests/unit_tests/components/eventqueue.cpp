@@ -0,0 +1,63 @@
+#include <thread>
+
+#include "components/eventqueue.cpp"
+#include "components/metrics.cpp"
+
+int main() {
+  using namespace polybar;
+
+  "coalesce"_test = [] {
+    auto queue = eventqueue::make();
+    queue->push(make_update_evt(false));
+    queue->push(make_update_evt(true));
+    queue->push(make_update_evt(false));
+
+    event evt{};
+    expect(queue->pop(evt));
+    expect(evt.type == event_type::UPDATE);
+    expect(evt.flag);
+    expect(queue->generation() == 3);
+    expect(queue->coalesced() == 2);
+  };
+
+  "priority"_test = [] {
+    auto queue = eventqueue::make();
+    queue->push(make_update_evt(false));
+    queue->push(make_check_evt());
+    queue->push(make_input_evt());
+    queue->push(make_quit_evt(true));
+
+    event evt{};
+    expect(queue->pop(evt) && evt.type == event_type::QUIT && evt.flag);
+    expect(queue->pop(evt) && evt.type == event_type::INPUT);
+    expect(queue->pop(evt) && evt.type == event_type::CHECK);
+    expect(queue->pop(evt) && evt.type == event_type::UPDATE);
+  };
+
+  "pacing"_test = [] {
+    auto queue = eventqueue::make(std::chrono::milliseconds{50});
+    event evt{};
+
+    queue->push(make_update_evt(false));
+    auto start = eventqueue::clock::now();
+    expect(queue->pop(evt) && evt.type == event_type::UPDATE);
+    expect(eventqueue::clock::now() - start < std::chrono::milliseconds{50});
+
+    queue->push(make_update_evt(false));
+    queue->push(make_input_evt());
+    expect(queue->pop(evt) && evt.type == event_type::INPUT);
+    expect(queue->pop(evt) && evt.type == event_type::UPDATE);
+    expect(eventqueue::clock::now() - start >= std::chrono::milliseconds{50});
+  };
+
+  "close"_test = [] {
+    auto queue = eventqueue::make();
+    std::thread closer([&] {
+      std::this_thread::sleep_for(std::chrono::milliseconds{10});
+      queue->close();
+    });
+    event evt{};
+    expect(!queue->pop(evt));
+    closer.join();
+  };
+}
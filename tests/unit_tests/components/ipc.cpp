@@ -0,0 +1,134 @@
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include "components/action_router.cpp"
+#include "components/ipc.cpp"
+#include "components/logger.cpp"
+#include "components/metrics.cpp"
+#include "events/signal_emitter.cpp"
+#include "events/signal_receiver.cpp"
+#include "utils/concurrency.cpp"
+#include "utils/factory.cpp"
+#include "utils/file.cpp"
+#include "utils/string.cpp"
+
+using namespace polybar;
+
+/**
+ * Accepts the hook "module/test1"
+ */
+class hook_receiver : public signal_receiver<SIGN_PRIORITY_CONTROLLER, signals::ipc::hook> {
+ public:
+  bool on(const signals::ipc::hook& evt) {
+    hooks++;
+    return evt.cast() == "module/test1";
+  }
+
+  int hooks{0};
+};
+
+int connect_client() {
+  struct sockaddr_un addr {};
+  addr.sun_family = AF_UNIX;
+  string path{string_util::replace(PATH_MESSAGING_SOCKET, "%pid%", to_string(getpid()))};
+  path.copy(addr.sun_path, path.size());
+  int fd{socket(AF_UNIX, SOCK_SEQPACKET, 0)};
+  if (connect(fd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) == -1) {
+    return -1;
+  }
+  return fd;
+}
+
+string receive(int fd) {
+  char buffer[BUFSIZ]{'\0'};
+  ssize_t bytes{recv(fd, buffer, sizeof(buffer), MSG_DONTWAIT)};
+  return bytes > 0 ? string{buffer, static_cast<size_t>(bytes)} : "";
+}
+
+/**
+ * Let the server handle activity on all of its sockets
+ */
+void serve(ipc& server) {
+  for (auto&& fd : server.get_file_descriptors()) {
+    server.receive_message(fd);
+  }
+}
+
+int main() {
+  auto& sig = signal_emitter::make();
+  auto& log = logger::make(loglevel::NONE);
+
+  "requests"_test = [&] {
+    ipc server{sig, log};
+    file_descriptor client{connect_client()};
+    expect(client);
+
+    serve(server);
+    expect(server.get_file_descriptors().size() == 2);
+
+    string request{"cmd:invalid\nfoo:bar\n"};
+    send(client, request.c_str(), request.size(), 0);
+    serve(server);
+
+    expect(receive(client) == "2 invalid command\n1 unknown message type\n");
+  };
+
+  "batch"_test = [&] {
+    hook_receiver receiver;
+    sig.attach(&receiver);
+
+    ipc server{sig, log};
+    file_descriptor client{connect_client()};
+    serve(server);
+
+    string request{"hook:module/test1\nhook:module/test2\nhook:module/test1"};
+    send(client, request.c_str(), request.size(), 0);
+    serve(server);
+
+    expect(receiver.hooks == 3);
+    expect(receive(client) == "0 ok\n2 no matching hook\n0 ok\n");
+
+    sig.detach(&receiver);
+  };
+
+  "stats"_test = [&] {
+    ipc server{sig, log};
+    file_descriptor client{connect_client()};
+    serve(server);
+
+    send(client, "stats", 5, 0);
+    serve(server);
+
+    auto reply = receive(client);
+    expect(reply.find("0 ok\n\nRuntime statistics") == 0);
+  };
+
+  "subscribe"_test = [&] {
+    ipc server{sig, log};
+    file_descriptor subscriber{connect_client()};
+    file_descriptor other{connect_client()};
+    serve(server);
+
+    send(subscriber, "subscribe", 9, 0);
+    serve(server);
+    expect(receive(subscriber) == "0 ok\n");
+
+    sig.emit(signals::ui::visibility_change{false});
+    sig.emit(signals::ui::button_press{"cmd"});
+
+    expect(receive(subscriber) == "event:visibility:0");
+    expect(receive(subscriber) == "event:action:cmd");
+    expect(receive(other).empty());
+  };
+
+  "disconnect"_test = [&] {
+    ipc server{sig, log};
+    {
+      file_descriptor client{connect_client()};
+      serve(server);
+      expect(server.get_file_descriptors().size() == 2);
+    }
+    serve(server);
+    expect(server.get_file_descriptors().size() == 1);
+  };
+}
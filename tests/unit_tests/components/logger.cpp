@@ -0,0 +1,114 @@
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <set>
+#include <sstream>
+
+#include "components/logger.cpp"
+#include "utils/concurrency.cpp"
+#include "utils/string.cpp"
+
+int main() {
+  using namespace polybar;
+
+  const auto read_output = [](int fd) {
+    string output;
+    char buffer[BUFSIZ];
+    ssize_t bytes;
+    while ((bytes = read(fd, buffer, sizeof(buffer))) > 0) {
+      output.append(buffer, bytes);
+    }
+    return output;
+  };
+
+  "output"_test = [&] {
+    int fds[2];
+    expect(pipe(fds) == 0);
+    fcntl(fds[0], F_SETFL, O_NONBLOCK);
+    {
+      logger log{loglevel::WARNING, fds[1]};
+      log.info("filtered");
+      log.warn("value: %s %d", "text"s, 5);
+      log.err("failure");
+      log.flush();
+    }
+    expect(read_output(fds[0]) == "polybar|warn:  value: text 5\npolybar|error: failure\n");
+    close(fds[0]);
+    close(fds[1]);
+  };
+
+  "truncate"_test = [&] {
+    int fds[2];
+    expect(pipe(fds) == 0);
+    fcntl(fds[0], F_SETFL, O_NONBLOCK);
+    {
+      logger log{loglevel::ERROR, fds[1]};
+      log.err(string(1000, 'x'));
+    }
+    auto output = read_output(fds[0]);
+    expect(output.size() < 600);
+    expect(output.substr(output.size() - 4) == "...\n");
+    close(fds[0]);
+    close(fds[1]);
+  };
+
+  /**
+   * Log messages from 4 threads into a temporary file and return the
+   * number of distinct messages that were written along with the
+   * number of messages the logger reports as dropped
+   */
+  const auto log_concurrently = [&](int per_thread) {
+    char path[]{"/tmp/polybar-logger-XXXXXX"};
+    int fd{mkstemp(path)};
+    expect(fd != -1);
+    unlink(path);
+
+    size_t dropped{0};
+    {
+      logger log{loglevel::INFO, fd};
+      vector<thread> threads;
+      for (int t = 0; t < 4; t++) {
+        threads.emplace_back([&log, t, per_thread] {
+          for (int i = 0; i < per_thread; i++) {
+            log.info("thread %d message %d", t, i);
+          }
+        });
+      }
+      for (auto&& t : threads) {
+        t.join();
+      }
+      log.flush();
+      dropped = log.dropped();
+    }
+
+    lseek(fd, 0, SEEK_SET);
+    std::istringstream output{read_output(fd)};
+    close(fd);
+
+    size_t lines{0};
+    std::set<string> messages;
+    for (string line; std::getline(output, line);) {
+      if (line.find(" thread ") != string::npos) {
+        messages.emplace(line);
+        lines++;
+      }
+    }
+
+    // Lines would be lost or repeated if the ring buffer handed out a slot twice
+    expect(messages.size() == lines);
+
+    return std::make_pair(lines, dropped);
+  };
+
+  "concurrent"_test = [&] {
+    auto result = log_concurrently(2000);
+    expect(result.first + result.second == 8000);
+  };
+
+  "concurrent without drops"_test = [&] {
+    // Fewer messages than buffer slots, nothing can be dropped
+    auto result = log_concurrently(100);
+    expect(result.first == 400);
+    expect(result.second == 0);
+  };
+}
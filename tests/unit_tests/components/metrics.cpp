@@ -0,0 +1,79 @@
+#include <thread>
+
+#include "components/metrics.cpp"
+
+int main() {
+  using namespace polybar;
+  using namespace std::chrono_literals;
+
+  "counter"_test = [] {
+    auto& m = metrics::make();
+    auto id = m.counter("counter");
+    expect(m.counter("counter") == id);
+    expect(m.counter("other") != id);
+    m.increment(id);
+    m.increment(id, 2);
+    expect(m.count(id) == 3);
+  };
+
+  "invalid"_test = [] {
+    auto& m = metrics::make();
+    m.increment(metrics::INVALID);
+    m.record(metrics::INVALID, 1ms);
+    expect(m.count(metrics::INVALID) == 0);
+    expect(m.timings(metrics::INVALID).count == 0);
+  };
+
+  "timer"_test = [] {
+    auto& m = metrics::make();
+    auto id = m.timer("timer");
+    expect(m.timer("timer") == id);
+
+    for (int i = 0; i < 98; i++) {
+      m.record(id, 10us);
+    }
+    m.record(id, 100us);
+    m.record(id, 1000us);
+
+    auto t = m.timings(id);
+    expect(t.name == "timer");
+    expect(t.count == 100);
+    expect(t.sum == 98 * 10 + 100 + 1000);
+    expect(t.max == 1000);
+    expect(t.percentile(50) == 16);
+    expect(t.percentile(98) == 128);
+    expect(t.percentile(99) == 1000);
+  };
+
+  "threads"_test = [] {
+    auto& m = metrics::make();
+    auto id = m.timer("threads");
+
+    // Histograms of exited threads are kept
+    vector<std::thread> threads;
+    for (int i = 0; i < 4; i++) {
+      threads.emplace_back([&] {
+        for (int j = 0; j < 1000; j++) {
+          m.record(id, 1us);
+        }
+      });
+    }
+    for (auto&& t : threads) {
+      t.join();
+    }
+    m.record(id, 1us);
+
+    expect(m.timings(id).count == 4001);
+  };
+
+  "report"_test = [] {
+    auto& m = metrics::make();
+    m.increment(m.counter("report counter"), 42);
+    m.record(m.timer("report timer"), 5us);
+
+    auto report = m.report();
+    expect(report.find("report counter") != string::npos);
+    expect(report.find("42") != string::npos);
+    expect(report.find("report timer") != string::npos);
+  };
+}
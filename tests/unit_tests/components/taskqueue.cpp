@@ -0,0 +1,73 @@
+#include <atomic>
+#include <thread>
+
+#include "components/metrics.cpp"
+#include "components/taskqueue.cpp"
+
+int main() {
+  using namespace polybar;
+
+  "defer_unique"_test = [] {
+    auto queue = taskqueue::make();
+    std::atomic<int> value{0};
+    queue->defer_unique("task", 10ms, [&](size_t) { value = 1; });
+    queue->defer_unique("task", 10ms, [&](size_t) { value = 2; });
+    std::this_thread::sleep_for(50ms);
+    expect(value == 2);
+    expect(!queue->exist("task"));
+  };
+
+  "throttle_burst"_test = [] {
+    // Simulate a burst of dock requests from many tray clients,
+    // each one requesting a redraw of the tray window
+    auto queue = taskqueue::make();
+    std::atomic<size_t> requests{0};
+    std::atomic<size_t> redraws{0};
+    std::atomic<size_t> drawn{0};
+
+    auto redraw = [&](size_t) {
+      redraws++;
+      drawn = requests.load();
+    };
+
+    vector<std::thread> clients;
+    for (size_t i = 0; i < 16; i++) {
+      clients.emplace_back([&] {
+        for (size_t j = 0; j < 50; j++) {
+          requests++;
+          queue->throttle("tray-redraw", 20ms, redraw);
+          std::this_thread::sleep_for(1ms);
+        }
+      });
+    }
+    for (auto&& client : clients) {
+      client.join();
+    }
+
+    std::this_thread::sleep_for(100ms);
+
+    expect(drawn == 16 * 50);
+    expect(redraws > 0);
+    expect(redraws < requests / 4);
+  };
+
+  "throttle_interval"_test = [] {
+    auto queue = taskqueue::make();
+    vector<taskqueue::deferred::timepoint> runs;
+    std::mutex lock;
+
+    auto fn = [&](size_t) {
+      std::lock_guard<std::mutex> guard(lock);
+      runs.emplace_back(chrono::time_point_cast<taskqueue::deferred::duration>(taskqueue::deferred::clock::now()));
+    };
+
+    queue->throttle("task", 30ms, fn);
+    std::this_thread::sleep_for(10ms);
+    queue->throttle("task", 30ms, fn);
+    std::this_thread::sleep_for(80ms);
+
+    std::lock_guard<std::mutex> guard(lock);
+    expect(runs.size() == 2);
+    expect(runs.size() == 2 && runs[1] - runs[0] >= 29ms);
+  };
+}
@@ -36,4 +36,32 @@ int main() {
     expect(color_util::simplify_hex("#ee223344") == "#ee223344");
     expect(color_util::simplify_hex("#ff234567") == "#234567");
   };
+
+  "parse"_test = [] {
+    static_expect(color_util::parse("#abc") == 0xffaabbcc);
+    static_expect(color_util::parse("#8abc") == 0x88aabbcc);
+    static_expect(color_util::parse("#a1b2c3") == 0xffa1b2c3);
+    static_expect(color_util::parse("#80a1b2c3") == 0x80a1b2c3);
+    static_expect(color_util::parse("#xyz", 1) == 1);
+
+    expect(color_util::parse("#fff"s) == 0xffffffff);
+    expect(color_util::parse("fff"s) == 0xffffffff);
+    expect(color_util::parse("#0F0A"s) == 0x00ff00aa);
+    expect(color_util::parse("#DeadBe"s) == 0xffdeadbe);
+    expect(color_util::parse("#00000000"s, 1) == 0);
+    expect(color_util::parse("c0ffee00"s) == 0xc0ffee00);
+
+    expect(color_util::parse(""s, 1) == 1);
+    expect(color_util::parse("#"s, 1) == 1);
+    expect(color_util::parse("#12"s, 1) == 1);
+    expect(color_util::parse("#12345"s, 1) == 1);
+    expect(color_util::parse("#1234567"s, 1) == 1);
+    expect(color_util::parse("#123456789"s, 1) == 1);
+    expect(color_util::parse("#12345g"s, 1) == 1);
+    expect(color_util::parse("##123"s, 1) == 1);
+
+    expect(color_util::parse_hex("#Abc") == "#ffaabbcc");
+    expect(color_util::parse_hex("#1234") == "#11223344");
+    expect(color_util::parse_hex("invalid").empty());
+  };
 }
@@ -0,0 +1,39 @@
+#include "utils/concurrency.hpp"
+
+int main() {
+  using namespace polybar;
+
+  "parallel_for"_test = [] {
+    vector<int> values(100, 0);
+    concurrency_util::parallel_for(values.size(), [&](size_t i) { values[i] = i * 2; }, 4);
+    for (size_t i = 0; i < values.size(); i++) {
+      expect(values[i] == static_cast<int>(i * 2));
+    }
+  };
+
+  "parallel_for_empty"_test = [] {
+    size_t calls{0};
+    concurrency_util::parallel_for(0, [&](size_t) { calls++; });
+    expect(calls == 0);
+  };
+
+  "parallel_for_single_worker"_test = [] {
+    vector<size_t> order;
+    concurrency_util::parallel_for(5, [&](size_t i) { order.emplace_back(i); }, 1);
+    expect(order == vector<size_t>({0, 1, 2, 3, 4}));
+  };
+
+  "parallel_for_rethrow"_test = [] {
+    auto thrown = false;
+    try {
+      concurrency_util::parallel_for(10, [](size_t i) {
+        if (i == 3) {
+          throw std::runtime_error("failure");
+        }
+      }, 2);
+    } catch (const std::runtime_error&) {
+      thrown = true;
+    }
+    expect(thrown);
+  };
+}
@@ -115,4 +115,39 @@ int main() {
     string aaa = "aaa";
     expect(aaa - "aaaaa" == "aaa");
   };
+
+  "utf8_to_ucs4"_test = [] {
+    const auto decode = [](const string& s, bool valid = true) {
+      vector<uint32_t> result;
+      expect(string_util::utf8_to_ucs4(s.data(), s.size(), result) == valid);
+      return result;
+    };
+
+    expect(decode("").empty());
+    expect((decode("abc") == vector<uint32_t>{'a', 'b', 'c'}));
+    expect((decode("\u00e9\u20ac\U0001f600") == vector<uint32_t>{0xe9, 0x20ac, 0x1f600}));
+    expect((decode("\U0010ffff") == vector<uint32_t>{0x10ffff}));
+
+    // Long ascii runs mixed with multibyte sequences
+    string text{"The quick brown fox jumps over \u00e9 the lazy dog, 0123456789abcdef\u00e9"};
+    auto result = decode(text);
+    expect(result.size() == text.size() - 2);
+    expect(result[31] == 0xe9);
+    expect(result[32] == ' ');
+    expect(result.back() == 0xe9);
+
+    // Truncated, stray, overlong, surrogate and out of range sequences
+    expect((decode("a\xc3", false) == vector<uint32_t>{'a', 0xfffd}));
+    expect((decode("\x80" "a", false) == vector<uint32_t>{0xfffd, 'a'}));
+    expect((decode("\xe2\x82" "a", false) == vector<uint32_t>{0xfffd, 'a'}));
+    expect((decode("\xc0\xaf", false) == vector<uint32_t>{0xfffd}));
+    expect((decode("\xed\xa0\x80", false) == vector<uint32_t>{0xfffd}));
+    expect((decode("\xf4\x90\x80\x80", false) == vector<uint32_t>{0xfffd}));
+    expect((decode("\xff", false) == vector<uint32_t>{0xfffd}));
+
+    // Decoded text is appended to the buffer
+    vector<uint32_t> buffer{'x'};
+    string_util::utf8_to_ucs4("y", 1, buffer);
+    expect((buffer == vector<uint32_t>{'x', 'y'}));
+  };
 }
@@ -1,14 +1,42 @@
-#include "utils/string.cpp"
-#include "x11/atoms.cpp"
-#include "x11/connection.cpp"
-#include "x11/xutils.cpp"
-#include "x11/xlib.cpp"
+#include "common/fake_server.hpp"
+#include "utils/memory.hpp"
+#include "x11/atoms.hpp"
+#include "x11/connection.hpp"
 
 int main() {
   using namespace polybar;
 
   "id"_test = [] {
-    connection& conn{configure_connection().create<connection&>()};
+    fake_server server;
+    connection conn{server.connect()};
     expect(conn.id(static_cast<xcb_window_t>(0x12345678)) == "0x12345678");
   };
+
+  "setup"_test = [] {
+    fake_server server;
+    connection conn{server.connect()};
+    server.sync(conn);
+    expect(conn.root() == fake_server::ROOT);
+    expect(server.count(XCB_INTERN_ATOM) == memory_util::countof(ATOMS));
+  };
+
+  "ensure_event_mask"_test = [] {
+    fake_server server;
+    connection conn{server.connect()};
+    server.sync(conn);
+    server.clear();
+
+    conn.ensure_event_mask(conn.root(), XCB_EVENT_MASK_PROPERTY_CHANGE);
+    server.sync(conn);
+
+    auto requests = server.requests();
+    expect(server.count(XCB_GET_WINDOW_ATTRIBUTES) == 1);
+    expect(server.count(XCB_CHANGE_WINDOW_ATTRIBUTES) == 1);
+    expect(requests[0].opcode == XCB_GET_WINDOW_ATTRIBUTES);
+    expect(requests[1].opcode == XCB_CHANGE_WINDOW_ATTRIBUTES);
+
+    auto* req = reinterpret_cast<const xcb_change_window_attributes_request_t*>(requests[1].data.data());
+    expect(req->window == fake_server::ROOT);
+    expect(req->value_mask == XCB_CW_EVENT_MASK);
+  };
 }
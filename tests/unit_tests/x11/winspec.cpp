@@ -1,15 +1,13 @@
-#include "utils/string.cpp"
-#include "x11/atoms.cpp"
-#include "x11/connection.cpp"
+#include "common/fake_server.hpp"
+#include "x11/connection.hpp"
 #include "x11/winspec.hpp"
-#include "x11/xutils.cpp"
-#include "x11/xlib.cpp"
 
 int main() {
   using namespace polybar;
 
   "cw_create"_test = [] {
-    connection& conn{configure_connection().create<connection&>()};
+    fake_server server;
+    connection conn{server.connect()};
     auto id = conn.generate_id();
 
     // clang-format off
@@ -30,4 +28,26 @@ int main() {
     expect(rect.x == 10);
     expect(rect.y == -20);
   };
+
+  "cw_flush"_test = [] {
+    fake_server server;
+    connection conn{server.connect()};
+    server.sync(conn);
+    server.clear();
+
+    auto win = winspec(conn) << cw_size(100, 200) << cw_pos(10, -20) << cw_flush();
+    server.sync(conn);
+
+    auto requests = server.requests();
+    expect(requests.size() == 1);
+    expect(requests[0].opcode == XCB_CREATE_WINDOW);
+
+    auto* req = reinterpret_cast<const xcb_create_window_request_t*>(requests[0].data.data());
+    expect(req->wid == win);
+    expect(req->parent == fake_server::ROOT);
+    expect(req->x == 10);
+    expect(req->y == -20);
+    expect(req->width == 100);
+    expect(req->height == 200);
+  };
 }